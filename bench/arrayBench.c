@@ -0,0 +1,162 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// arrayBench.c		Measure the speed of common array operations on large arrays: filling, searching, freeing, pushing,
+//			using an array as a queue, and copying an array.
+
+#include "bench.h"
+#include "cxl/datum.h"
+#include "cxl/array.h"
+
+#define ElementCount	1000000		// Number of elements in large arrays.
+#define QueueLen	50000		// Number of elements resident in queue.
+#define CopyLen		1000		// Number of elements in copied array.
+#define CopyCount	20000		// Number of times array is copied.
+
+static double best[7];			// Best time of each test.
+
+// Save time of a test if it is the best so far.
+static void save(int test, double t) {
+
+	if(t < best[test])
+		best[test] = t;
+	}
+
+// Create and return an empty array, or exit if error.
+static Array *create(void) {
+	Array *pArray = anew(0, NULL);
+
+	if(pArray == NULL)
+		fail();
+	return pArray;
+	}
+
+// Push ElementCount new integer datums onto an array (which takes ownership of them).
+static void pushInts(Array *pArray) {
+	Datum *pDatum;
+
+	for(long i = 0; i < ElementCount; ++i) {
+		if(dnew(&pDatum) != 0)
+			fail();
+		dsetint(i, pDatum);
+		if(apush(pArray, pDatum, 0) != 0)
+			fail();
+		}
+	}
+
+// Time array filling, searching, freeing, and pushing.
+static void runLarge(void) {
+	Array *pArray;
+	Datum val;
+	double t0;
+
+	dinit(&val);
+	pArray = create();
+	dsetint(42, &val);
+	t0 = now();
+	if(afill(pArray, &val, 0, ElementCount, AOpGrow) != 0)
+		fail();
+	save(0, now() - t0);
+
+	// Search for a value in the last element.
+	dsetint(-1, aget(pArray, -1, 0));
+	dsetint(-1, &val);
+	t0 = now();
+	if(aindex(pArray, &val, 0) != ElementCount - 1)
+		fail();
+	save(1, now() - t0);
+
+	t0 = now();
+	afree(pArray);
+	save(2, now() - t0);
+
+	pArray = create();
+	t0 = now();
+	pushInts(pArray);
+	save(3, now() - t0);
+	afree(pArray);
+	}
+
+// Time using an array as a FIFO queue with QueueLen elements resident.
+static void runQueue(void) {
+	Array *pArray = create();
+	Datum *pDatum;
+	double t0;
+
+	for(long i = 0; i < QueueLen; ++i) {
+		if(dnew(&pDatum) != 0)
+			fail();
+		dsetint(i, pDatum);
+		if(apush(pArray, pDatum, 0) != 0)
+			fail();
+		}
+	t0 = now();
+	for(long i = 0; i < ElementCount; ++i) {
+		if(dnew(&pDatum) != 0)
+			fail();
+		dsetint(i, pDatum);
+		if(apush(pArray, pDatum, 0) != 0 || (pDatum = ashift(pArray)) == NULL)
+			fail();
+		dfree(pDatum);
+		}
+	save(4, now() - t0);
+	afree(pArray);
+	}
+
+// Time copying an array of mixed values with dcpy(), alone and followed by a modification of the copy (which
+// unshares it).
+static void runCopy(void) {
+	Array *pArray = create();
+	Datum src, dest, val;
+	double t0;
+
+	dinit(&src);
+	dinit(&dest);
+	dinit(&val);
+	for(long i = 0; i < CopyLen; ++i) {
+		if(i % 2 == 0)
+			dsetint(i, &val);
+		else if(dsetstr("a string value that is long enough to be allocated", &val) != 0)
+			fail();
+		if(apush(pArray, &val, AOpCopy) != 0)
+			fail();
+		}
+	dadoptarray(pArray, &src);
+	t0 = now();
+	for(long i = 0; i < CopyCount; ++i)
+		if(dcpy(&dest, &src) != 0)
+			fail();
+	save(5, now() - t0);
+
+	t0 = now();
+	for(long i = 0; i < CopyCount; ++i) {
+		if(dcpy(&dest, &src) != 0)
+			fail();
+		dsetint(i, &val);
+		if(apush(dest.u.pArray, &val, AOpCopy) != 0)
+			fail();
+		}
+	save(6, now() - t0);
+	dclear(&src);
+	dclear(&dest);
+	dclear(&val);
+	}
+
+int main(void) {
+	static const char *names[] = {"afill", "aindex", "afree", "apush", "queue push+shift", "dcpy", "dcpy+apush"};
+
+	for(size_t i = 0; i < elementsof(best); ++i)
+		best[i] = 1e9;
+	for(int run = 0; run < BenchRuns; ++run) {
+		runLarge();
+		runQueue();
+		runCopy();
+		}
+	for(int i = 0; i < 5; ++i)
+		printf("%-18s %8.2f ms  (%d elements)\n", names[i], best[i] * 1e3, ElementCount);
+	for(int i = 5; i < 7; ++i)
+		printf("%-18s %8.3f us  (%d elements)\n", names[i], best[i] / CopyCount * 1e6, CopyLen);
+	return 0;
+	}
@@ -0,0 +1,33 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// bench.h		Definitions shared by the CXL benchmark programs.
+
+#ifndef bench_h
+#define bench_h
+
+#include "stdos.h"
+#include "cxl/excep.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BenchRuns	5		// Number of times each timed operation is repeated (best time is reported).
+
+// Return current monotonic time in seconds.
+static inline double now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+	}
+
+// Print current exception message and exit.  Called when a library function fails.
+static inline void fail(void) {
+
+	fprintf(stderr, "Error: %s\n", cxlExcep.msg != NULL ? cxlExcep.msg : "unknown");
+	exit(1);
+	}
+#endif
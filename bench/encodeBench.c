@@ -0,0 +1,87 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// encodeBench.c	Measure dencode() and ddecode() speed on a large array of mixed integers, strings, and real numbers, with
+//			dtos() conversion to a string for comparison.
+
+#include "bench.h"
+#include "cxl/datum.h"
+#include "cxl/array.h"
+
+#define ElementCount	200000		// Number of elements in array.
+
+// Report best time of given test.
+static void report(const char *name, double best, size_t size) {
+
+	if(size > 0)
+		printf("%-12s %8.2f ms  (%zu bytes)\n", name, best * 1e3, size);
+	else
+		printf("%-12s %8.2f ms\n", name, best * 1e3);
+	}
+
+int main(void) {
+	Array *pArray;
+	Datum array, enc, str, dec;
+	DFab fab;
+	char buf[32];
+	double t0, t1, t2, t3, t4, best[4] = {1e9, 1e9, 1e9, 1e9};
+
+	// Build the array.
+	if((pArray = anew(ElementCount, NULL)) == NULL)
+		fail();
+	for(ArraySize i = 0; i < ElementCount; ++i)
+		switch(i % 3) {
+			case 0:
+				dsetint(i * 37 - 500000, pArray->elements + i);
+				break;
+			case 1:
+				sprintf(buf, "string number %d", (int) i);
+				if(dsetstr(buf, pArray->elements + i) != 0)
+					fail();
+				break;
+			default:
+				dsetreal(i / 7.0, pArray->elements + i);
+			}
+	dinit(&array);
+	dinit(&enc);
+	dinit(&str);
+	dinit(&dec);
+	dadoptarray(pArray, &array);
+
+	// Time each operation.
+	for(int run = 0; run < BenchRuns; ++run) {
+		t0 = now();
+		if(dopenwith(&fab, &enc, FabClear) != 0 || dencode(&array, &fab) != 0 || dclose(&fab, FabMem) != 0)
+			fail();
+		t1 = now();
+		if(dtos(&str, &array, NULL, DCvtLang) != 0)
+			fail();
+		t2 = now();
+		if(ddecode(&dec, enc.u.mem.ptr, enc.u.mem.size, 0) < 0)
+			fail();
+		dclear(&dec);
+		t3 = now();
+		if(ddecode(&dec, enc.u.mem.ptr, enc.u.mem.size, DDecRef) < 0)
+			fail();
+		dclear(&dec);
+		t4 = now();
+		if(t1 - t0 < best[0])
+			best[0] = t1 - t0;
+		if(t2 - t1 < best[1])
+			best[1] = t2 - t1;
+		if(t3 - t2 < best[2])
+			best[2] = t3 - t2;
+		if(t4 - t3 < best[3])
+			best[3] = t4 - t3;
+		}
+	report("dencode", best[0], enc.u.mem.size);
+	report("dtos", best[1], dstrlen(&str));
+	report("ddecode", best[2], 0);
+	report("ddecode ref", best[3], 0);
+	dclear(&array);
+	dclear(&enc);
+	dclear(&str);
+	return 0;
+	}
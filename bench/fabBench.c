@@ -0,0 +1,55 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// fabBench.c		Measure fabrication (DFab) throughput when building large strings from pieces of various sizes.
+
+#include "bench.h"
+#include "cxl/datum.h"
+#include <string.h>
+
+#define ResultSize	(1 << 20)	// Size of each string built, in bytes.
+#define Reps		200		// Number of strings built per test.
+
+// Build Reps strings of ResultSize bytes from pieces of given size with dputs() (or dputmem() if "mem" is true), appending or
+// prepending, and report the throughput of the write phase and of the write and close phases together.
+static void run(const char *name, size_t pieceSize, bool mem, bool prepend) {
+	static char piece[1024];
+	DFab fab;
+	Datum datum;
+	double t0, t1, tPut = 0.0, tAll = 0.0;
+	size_t n = ResultSize / pieceSize;
+
+	memset((void *) piece, 'p', sizeof(piece));
+	piece[pieceSize] = '\0';
+	dinit(&datum);
+	for(int rep = 0; rep < Reps; ++rep) {
+		t0 = now();
+		if(dopenwith(&fab, &datum, prepend ? FabPrepend : FabClear) != 0)
+			fail();
+		for(size_t i = 0; i < n; ++i)
+			if((mem ? dputmem((void *) piece, pieceSize, &fab, 0) : dputs(piece, &fab, 0)) != 0)
+				fail();
+		t1 = now();
+		if(dclose(&fab, mem ? FabMem : FabStr) != 0)
+			fail();
+		tPut += t1 - t0;
+		tAll += now() - t0;
+		if(prepend)
+			dsetnull(&datum);
+		}
+	printf("%-22s put %8.0f MB/s   put+close %8.0f MB/s\n", name, (double) n * pieceSize * Reps / tPut / 1e6,
+	 (double) n * pieceSize * Reps / tAll / 1e6);
+	dclear(&datum);
+	}
+
+int main(void) {
+
+	run("dputs 1K append", 1023, false, false);
+	run("dputmem 1K", 1023, true, false);
+	run("dputs 1K prepend", 1023, false, true);
+	run("dputs 64-byte append", 64, false, false);
+	run("dputs 12-byte append", 12, false, false);
+	return 0;
+	}
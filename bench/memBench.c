@@ -0,0 +1,73 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// memBench.c		Measure heap memory used per element of large arrays of integers, real numbers, and short strings.
+//
+// Notes:
+//  1. Heap usage is measured with mallinfo2(), so figures are only reported on platforms with glibc 2.33 or later.  The
+//     size of a Datum object is reported on all platforms.
+
+#include "bench.h"
+#include "cxl/datum.h"
+#include "cxl/array.h"
+#if __GLIBC__ && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#define HeapStats	1
+#endif
+
+#define ElementCount	1000000		// Number of elements in each array.
+
+// Return number of heap bytes in use (including large blocks allocated with mmap()), or zero if unknown.
+static size_t heapUsed(void) {
+
+#if HeapStats
+	struct mallinfo2 mi = mallinfo2();
+
+	return mi.uordblks + mi.hblkhd;
+#else
+	return 0;
+#endif
+	}
+
+// Build an array of ElementCount elements of given kind with apush() and report heap bytes used per element.
+static void run(const char *name, int kind) {
+	Array *pArray;
+	Datum val;
+	char buf[32];
+	size_t before = heapUsed();
+
+	dinit(&val);
+	if((pArray = anew(0, NULL)) == NULL)
+		fail();
+	for(long i = 0; i < ElementCount; ++i) {
+		switch(kind) {
+			case 0:
+				dsetint(i, &val);
+				break;
+			case 1:
+				dsetreal(i * 0.5, &val);
+				break;
+			default:
+				sprintf(buf, "item-%07ld", i);
+				if(dsetstr(buf, &val) != 0)
+					fail();
+			}
+		if(apush(pArray, &val, AOpCopy) != 0)
+			fail();
+		}
+	if(before > 0 || heapUsed() > 0)
+		printf("%-14s %6.1f bytes/element\n", name, (double) (heapUsed() - before) / ElementCount);
+	afree(pArray);
+	dclear(&val);
+	}
+
+int main(void) {
+
+	printf("sizeof(Datum)  %6zu bytes\n", sizeof(Datum));
+	run("int", 0);
+	run("real", 1);
+	run("short string", 2);
+	return 0;
+	}
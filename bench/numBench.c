@@ -0,0 +1,69 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// numBench.c		Measure number-to-string conversion throughput, directly and via atos() on large numeric arrays.
+
+#include "bench.h"
+#include "cxl/datum.h"
+#include "cxl/array.h"
+#include "cxl/lib.h"
+
+#define ElementCount	1000000		// Number of elements in each array.
+
+// Fill an array with ElementCount random integers (if "real" is false) or real numbers, convert it to a string with atos()
+// BenchRuns times, and report the best time.
+static void runArray(const char *name, bool real) {
+	Array *pArray;
+	Datum result;
+	double t0, t, best = 1e9;
+
+	if((pArray = anew(ElementCount, NULL)) == NULL)
+		fail();
+	srand(1);
+	for(ArraySize i = 0; i < ElementCount; ++i) {
+		if(real)
+			dsetreal((double) rand() / 7.0, pArray->elements + i);
+		else
+			dsetint((long) rand() * 1234567 - 987654321, pArray->elements + i);
+		}
+	dinit(&result);
+	for(int run = 0; run < BenchRuns; ++run) {
+		t0 = now();
+		if(atos(&result, pArray, ",", 0) != 0)
+			fail();
+		if((t = now() - t0) < best)
+			best = t;
+		}
+	printf("atos %-14s %8.2f ms (%zu bytes)\n", name, best * 1e3, dstrlen(&result));
+	dclear(&result);
+	afree(pArray);
+	}
+
+// Convert ElementCount random numbers with inttos() and realtos() directly and report the rate of each.
+static void runDirect(void) {
+	char buf[NumBufSize];
+	double t0, t;
+	size_t len = 0;
+
+	srand(1);
+	t0 = now();
+	for(long i = 0; i < ElementCount; ++i)
+		len += inttos((long) rand() * 1234567 - 987654321, buf) - buf;
+	t = now() - t0;
+	printf("inttos               %8.1f M/s\n", ElementCount / t / 1e6);
+	t0 = now();
+	for(long i = 0; i < ElementCount; ++i)
+		len += realtos((double) rand() / 7.0, buf) - buf;
+	t = now() - t0;
+	printf("realtos              %8.1f M/s (%zu bytes total)\n", ElementCount / t / 1e6, len);
+	}
+
+int main(void) {
+
+	runArray("ints", false);
+	runArray("reals", true);
+	runDirect();
+	return 0;
+	}
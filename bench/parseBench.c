@@ -0,0 +1,99 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// parseBench.c		Measure dparse() speed on text produced by dtos() with DCvtLang flags for arrays of mixed values, long
+//			strings, strings with escape sequences, and real numbers.
+
+#include "bench.h"
+#include "cxl/datum.h"
+#include "cxl/array.h"
+
+#define StrLen		1999		// Length of long strings.
+
+// Convert given array to text, then report the best time to parse the text and to create it.  Free the array.
+static void run(const char *name, Array *pArray) {
+	Datum array, text, parsed;
+	double t0, t1, bestParse = 1e9, bestCvt = 1e9;
+
+	dinit(&array);
+	dinit(&text);
+	dinit(&parsed);
+	dadoptarray(pArray, &array);
+	for(int run = 0; run < BenchRuns; ++run) {
+		t0 = now();
+		if(dtos(&text, &array, NULL, DCvtLang) != 0)
+			fail();
+		if((t1 = now()) - t0 < bestCvt)
+			bestCvt = t1 - t0;
+		t0 = now();
+		if(dparse(&parsed, dstr(&text), dstrlen(&text)) < 0)
+			fail();
+		if((t1 = now()) - t0 < bestParse)
+			bestParse = t1 - t0;
+		dclear(&parsed);
+		}
+	printf("%-10s %6.1f MB   dparse %8.2f ms (%5.0f MB/s)   dtos %8.2f ms\n", name, dstrlen(&text) / 1e6, bestParse * 1e3,
+	 dstrlen(&text) / bestParse / 1e6, bestCvt * 1e3);
+	dclear(&array);
+	dclear(&text);
+	}
+
+// Create an array of "count" elements, or exit if error.
+static Array *create(ArraySize count) {
+	Array *pArray = anew(count, NULL);
+
+	if(pArray == NULL)
+		fail();
+	return pArray;
+	}
+
+// Set a long string of lowercase letters in an array element, with a newline (which is escaped) every "nl" characters if
+// "nl" is not zero.
+static void setLongStr(Datum *pDatum, ArraySize i, int nl) {
+	char str[StrLen + 1];
+
+	for(int j = 0; j < StrLen; ++j)
+		str[j] = (nl > 0 && j % nl == 0) ? '\n' : 'a' + (i + j) % 26;
+	str[StrLen] = '\0';
+	if(dsetstr(str, pDatum) != 0)
+		fail();
+	}
+
+int main(void) {
+	Array *pArray;
+	char buf[32];
+
+	pArray = create(300000);
+	for(ArraySize i = 0; i < pArray->used; ++i)
+		switch(i % 3) {
+			case 0:
+				dsetint(i * 37 - 500000, pArray->elements + i);
+				break;
+			case 1:
+				sprintf(buf, "string number %d", (int) i);
+				if(dsetstr(buf, pArray->elements + i) != 0)
+					fail();
+				break;
+			default:
+				dsetreal(i / 7.0, pArray->elements + i);
+			}
+	run("mixed", pArray);
+
+	pArray = create(20000);
+	for(ArraySize i = 0; i < pArray->used; ++i)
+		setLongStr(pArray->elements + i, i, 0);
+	run("long str", pArray);
+
+	pArray = create(20000);
+	for(ArraySize i = 0; i < pArray->used; ++i)
+		setLongStr(pArray->elements + i, i, 40);
+	run("escaped", pArray);
+
+	pArray = create(500000);
+	for(ArraySize i = 0; i < pArray->used; ++i)
+		dsetreal((i * 7919 % 1000000) / 1000.0, pArray->elements + i);
+	run("reals", pArray);
+	return 0;
+	}
@@ -22,6 +22,7 @@
 #define AOpInPlace	0x0010		// Perform operation on first array argument; otherwise, make new array.
 #define AOpLast		0x0020		// Find last occurrence, otherwise first.
 #define AOpNonMatching	0x0040		// Return non-matching elements, otherwise matching.
+#define AOpConst	0x0080		// Element will not be modified, so don't unshare array (aget() only).
 
 // For internal use.
 #define AOpRemaining	0x1000		// Excessive length parameter indicates "all remaining elements".
@@ -34,10 +35,15 @@ typedef struct Array {
 	struct Array *next;		// Pointer to next array on (garbage) list -- for external use.
 	bool tagged;			// Array is tagged (for garbage collection) -- for external use.
 	uint32_t id;			// Random ID number used to detect an array that includes itself.
-	ArraySize size;			// Number of elements allocated.
+	ArraySize size;			// Number of elements allocated, beginning at first element.
 	ArraySize used;			// Number of elements currently in use.
-	Datum **elements;		// Array of (Datum *) elements.  Elements 0..(used - 1) always point to allocated
-					// Datum objects and elements used..(size - 1) are always undefined (un-allocated).
+	ArraySize head;			// Number of unused slots allocated before first element (for internal use).
+	Datum *elements;		// Contiguous array of Datum objects.  Elements 0..(used - 1) are always initialized
+					// and elements used..(size - 1) are always undefined.  Element pointers remain valid
+					// only until the array is resized or its elements are shifted or unshared, which
+					// includes removing or inserting an element at the beginning of the array.
+					// Elements may be shared with other arrays (see ashare()), so aunshare() must be
+					// called before they are modified directly.
 	} Array;
 
 #define aempty(array)	((array)->used == 0)
@@ -63,11 +69,17 @@ extern Array *amatch(Array *pArray1, const Array *pArray2, ushort aflags);
 extern Array *anew(ArraySize len, const Datum *pVal);
 extern Datum *apop(Array *pArray);
 extern int apush(Array *pArray, Datum *pVal, ushort aflags);
+extern int apushv(Array *pArray, Datum **vals, ArraySize count, ushort aflags);
 extern int aput(const Array *pArray, DFab *pFab, const char *delim, ushort cflags);
 extern Datum *ashift(Array *pArray);
+extern Array *ashare(const Array *pArray);
 extern Array *aslice(Array *pArray, ArraySize index, ArraySize len, ushort aflags);
+extern Array *asort(Array *pArray, int (*cmp)(const Datum *pDatum1, const Datum *pDatum2), ushort aflags);
+extern int asplice(Array *pArray, ArraySize index, ArraySize len, Datum **vals, ArraySize count, ushort aflags);
 extern Array *asplit(short delim, const char *src, int limit);
+extern Array *asplitref(short delim, const char *src, int limit);
 extern int atos(Datum *pDatum, const Array *pArray, const char *delim, ushort cflags);
 extern Array *auniq(Array *pArray1, const Array *pArray2, ushort aflags);
+extern int aunshare(Array *pArray);
 extern int aunshift(Array *pArray, Datum *pVal, ushort aflags);
 #endif
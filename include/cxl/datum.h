@@ -21,31 +21,53 @@ typedef struct {
 	void *ptr;				// Memory pointer.
 	} DMem;
 
+// String object: used for holding a long string and its length.
+typedef struct {
+	size_t len;				// Length of string (excluding terminating null), or DStrLenUnk if unknown.
+	char *ptr;				// String pointer.
+	} DStr;
+
+#define DStrLenUnk	((size_t) -1)		// Unknown string length.
+
 // Chunk object: used for holding chunks of memory for fabrication (DFab) objects.
 typedef struct DChunk {
 	struct DChunk *next;			// Link to next item in list.
 	DMem mem;				// Memory object.
 	} DChunk;
 
+// Rope object: used for holding a string or byte string as a sequence of separately allocated pieces, so that the result of a
+// large fabrication can be written out (via ffwriterope(), for example) without first being concatenated.
+typedef struct DRope {
+	size_t count;				// Number of pieces.
+	size_t size;				// Total size in bytes.
+	DMem pieces[];				// Pieces, in order.
+	} DRope;
+
 // Datum object: general purpose structure for holding a nil value, Boolean value, signed or unsigned long integer, real number,
-// string of any length, or byte string of any length.
+// string of any length, or byte string of any length.  A substring reference (type dat_substrRef) refers to a range of a string
+// or buffer owned by the caller via the mem member and is not null-terminated.  A mini string is stored in the object itself,
+// beginning at the miniStr member and extending through the u member, so it must be accessed with the dstr() macro.
 typedef ushort DatumType;
 typedef struct Datum {
-	struct Datum *next;			// Link to next item in list (for garbage collection).
 	DatumType type;				// Type of value.
-	char *str;				// String value if dat_miniStr, dat_longStr, or dat_longStrRef, otherwise NULL.
+	uchar flags;				// Garbage collection state (for internal use).
+	char miniStr[sizeof(void *) - sizeof(DatumType) - 1];
+						// Beginning of self-contained mini string (type dat_miniStr).
 	union {					// Current value.
 		short c;			// Character value.
 		long intNum;			// Signed integer.
 		ulong uintNum;			// Unsigned integer.
 		double realNum;			// Real number.
-		char miniStr[sizeof(DMem)];	// Self-contained mini-string.
-		char *longStr;			// String allocated on heap.
+		DStr longStr;			// String allocated on heap or referenced, with length.
 		DMem mem;			// Memory object.
 		struct Array *pArray;		// Array object.
+		DRope *pRope;			// Rope object.
 		} u;
 	} Datum;
 
+#define DMiniOffset	offsetof(Datum, miniStr)		// Offset of mini string in Datum object.
+#define DMiniSize	(sizeof(Datum) - DMiniOffset)		// Size of mini string buffer, including terminating null.
+
 // Datum types.
 #define dat_nil		0x0000			// Nil value.
 #define dat_false	0x0001			// False value.
@@ -61,17 +83,58 @@ typedef struct Datum {
 #define dat_byteStrRef	0x0400			// Byte string by reference.
 #define dat_array	0x0800			// Array by value.
 #define dat_arrayRef	0x1000			// Array by reference.
+#define dat_sharedStr	0x2000			// String by value, shared by reference count.
+#define dat_rope	0x4000			// String or byte string by value, held in pieces.
+#define dat_substrRef	0x8000			// Substring by reference (not null-terminated).
 
 #define DBoolMask	(dat_false | dat_true)				// Boolean types.
-#define DStrMask	(dat_miniStr | dat_longStr | dat_longStrRef)	// String types.
+#define DStrMask	(dat_miniStr | dat_longStr | dat_longStrRef | dat_sharedStr)	// String types.
 #define DMemMask	(dat_byteStr | dat_byteStrRef)			// Memory types.
 #define DArrayMask	(dat_array | dat_arrayRef)			// Array types.
 
-// Fabrication object: used to build a string or byte string in pieces, forward or backward.
+// Datum flags (for internal use).  These are set to zero by dinit() (so that they are valid in any initialized Datum object) and
+// are maintained for datums created by dnew() or dnewtrack() and for array elements.  They are not changed by dclear().
+#define DFTracked	0x01			// Datum is tracked (will be freed when garbage collection stack is popped).
+#define DFListed	0x02			// Datum is on garbage collection stack (tracked or not).
+#define DFDead		0x04			// Datum was freed while on stack -- release memory when popped.
+#define DFElement	0x08			// Datum is an array element (so an array set in it is cloned, not shared).
+
+// Scope object: used to mark a position on the garbage collection stack so that all datums tracked after that point can be
+// released in one step.  Scopes may be nested.
+typedef struct {
+	size_t depth;				// Stack depth when scope was opened.
+	size_t floor;				// Floor of enclosing scope (restored when scope is closed).
+	} DScope;
+
+// Garbage collection context: holds a garbage collection stack and a pool of released Datum objects for reuse.  Each thread has
+// its own default context, which may be replaced with a caller-managed one via dgarbswitch().
+typedef struct {
+	Datum **stack;				// Garbage collection stack (array of Datum pointers).
+	size_t count;				// Number of Datum objects on stack.
+	size_t size;				// Size of stack array.
+	size_t floor;				// Stack depth of innermost open scope.
+	void *pool;				// List of released Datum objects available for reuse.
+	size_t poolCount;			// Number of Datum objects in pool.
+	} DGarbCtx;
+
+// Symbol table: used to intern strings as symbols, so that all Datum objects holding an equal string share one copy of it and
+// can be compared for equality by pointer.  A table is not thread-safe, but each thread has its own default table.
+typedef struct {
+	void **slots;				// Hash array (of symbols).
+	size_t size;				// Number of slots (zero or a power of 2).
+	size_t count;				// Number of symbols in table.
+	size_t id;				// Unique table ID, or zero if not assigned yet.
+	} DSymTab;
+
+// Fabrication object: used to build a string or byte string in pieces, forward or backward.  Data is written to the work buffer
+// from either end, so it can be appended and prepended to the same object.  When the work buffer is full, it is grown or saved
+// in the chunk list, which holds the data preceding it (if appending) or following it (if prepending).
 typedef struct {
 	Datum *pDatum;				// Datum pointer.
-	DChunk *stack;				// Chunk stack (linked list).
-	char *bufCur;				// Next byte to store in buf.
+	DChunk *chunks;				// Chunk list (linked list, in order).
+	DChunk *lastChunk;			// Last chunk in list.
+	char *dataBeg;				// Beginning of data in buf.
+	char *dataEnd;				// End of data in buf.
 	char *bufEnd;				// Ending byte position in buf.
 	char *buf;				// Work buffer.
 	ushort flags;				// Operation mode.
@@ -82,9 +145,12 @@ typedef struct {
 #define FabAppend	1			// Append to caller's Datum object.
 #define FabPrepend	2			// Prepend to caller's Datum object.
 #define FabModeMask	0x0003			// Bits for mode value.
+#define FabSingle	0x0010			// Grow a single work buffer instead of saving it in chunks when full.
 
 // For internal use.
 #define FabTrack	0x0004			// Create tracked Datum object in fabrication object.
+#define FabReuse	0x0008			// Retain work buffer in fabrication object for reuse when closed.
+#define FabBinary	0x0020			// Data written to fabrication object may contain null bytes.
 
 // Fabrication close types, used by dclose().
 #define FabAuto		0x0000			// Automatically use FabStr (if able) or FabMem.
@@ -92,9 +158,10 @@ typedef struct {
 #define FabStrRef	0x0002			// String reference type (may not contain null bytes).
 #define FabMem		0x0004			// Memory type.
 #define FabMemRef	0x0008			// Memory reference type.
+#define FabRope		0x0010			// Rope type (pieces are not concatenated).
 
-#define FabCloseMask	0x000F
-#define FabCloseBits	4			// Number of close type bits in use (for validity checking).
+#define FabCloseMask	0x001F
+#define FabCloseBits	5			// Number of close type bits in use (for validity checking).
 
 // Flags for controlling datum conversions (cflags) for non-array datum types and array types.  These may be combined with
 // vizc() flags (like VizBaseHex), so higher bits are used.
@@ -130,6 +197,9 @@ typedef struct {
 // Flags for controlling datum operations (dflags).  These may be combined with array operation flags (aflags).
 #define DOpIgnore	AOpIgnore		// Ignore case in string comparisons.
 
+// Flags for decoding binary data via ddecode().
+#define DDecRef		0x0001			// Reference strings and byte strings in encoded data instead of copying them.
+
 // Macro shortcuts.
 #define dischr(pDatum)		((pDatum)->type == dat_char)
 #define disfalse(pDatum)	((pDatum)->type & (dat_false | dat_nil))
@@ -141,10 +211,16 @@ typedef struct {
 #define dtypmem(pDatum)		((pDatum)->type & DMemMask)
 #define dtypstr(pDatum)		((pDatum)->type & DStrMask)
 
+#define dsetnilval(pDatum)	((pDatum)->type = dat_nil)
+						// For internal use.  Set Datum object to nil without freeing its contents or
+						// changing its flags.
+#define dstr(pDatum)		((pDatum)->type == dat_miniStr ? (char *) (pDatum) + DMiniOffset : (pDatum)->u.longStr.ptr)
+						// String value of string type (DStrMask).
+
 #include "cxl/array.h"
 
-// External variables.
-extern Datum *datGarbHead;			// Head of list of temporary Datum records ("garbage collection").
+// Head of calling thread's current stack of temporary Datum records ("garbage collection").
+#define datGarbHead	dgarbhead()
 
 // External function declarations and aliases.
 extern void dadoptarray(struct Array *pArray, Datum *pDatum);
@@ -153,20 +229,34 @@ extern void dadoptstr(char *str, Datum *pDatum);
 
 extern void dconvchr(short c, Datum *pDatum);
 extern int dcpy(Datum *pDest, const Datum *pSrc);
+extern ssize_t ddecode(Datum *pDatum, const void *buf, size_t size, ushort flags);
+extern int dencode(const Datum *pDatum, DFab *pFab);
 extern bool deq(const Datum *pDatum1, const Datum *pDatum2, ushort dflags);
+extern size_t dhash(const Datum *pDatum, ushort dflags);
+extern DGarbCtx *dgarbctx(void);
+extern void dgarbfree(DGarbCtx *pCtx);
+extern Datum *dgarbhead(void);
+extern void dgarbinit(DGarbCtx *pCtx);
 extern void dgarbpop(const Datum *pDatum);
+extern DGarbCtx *dgarbswitch(DGarbCtx *pCtx);
 extern void dclear(Datum *pDatum);
+extern int dcmp(const Datum *pDatum1, const Datum *pDatum2, ushort dflags);
 extern int dclose(DFab *pFab, ushort type);
 extern bool dfabempty(const DFab *pFab);
+extern int dfabmode(DFab *pFab, ushort mode);
+extern int dflatten(Datum *pDatum);
 extern void dfree(Datum *pDatum);
 extern void dinit(Datum *pDatum);
 extern bool disempty(const Datum *pDatum);
 extern bool disnull(const Datum *pDatum);
+extern bool dissym(const Datum *pDatum);
 extern int dnew(Datum **ppDatum);
 extern int dnewtrack(Datum **ppDatum);
 extern int dopen(DFab *pFab);
 extern int dopentrack(DFab *pFab);
+extern int dopenreuse(DFab *pFab, Datum *pDatum, ushort mode);
 extern int dopenwith(DFab *pFab, Datum *pDatum, ushort mode);
+extern ssize_t dparse(Datum *pDatum, const char *str, size_t len);
 
 extern int dputc(short c, DFab *pFab, ushort cflags);
 extern int dputd(const Datum *pDatum, DFab *pFab, const char *delim, ushort cflags);
@@ -176,7 +266,10 @@ extern int dputs(const char *str, DFab *pFab, ushort cflags);
 extern int dputsubstr(const char *str, size_t len, DFab *pFab, ushort cflags);
 
 extern int drelease(Datum *pDatum);
+extern void dreset(DFab *pFab);
 extern int dsalloc(Datum *pDatum, size_t len);
+extern void dscopeclose(DScope *pScope);
+extern void dscopeopen(DScope *pScope);
 
 extern int dsetarray(const struct Array *pArray, Datum *pDatum);
 extern void dsetarrayref(struct Array *pArray, Datum *pDatum);
@@ -191,16 +284,25 @@ extern void dsetreal(double d, Datum *pDatum);
 extern int dsetstr(const char *str, Datum *pDatum);
 extern void dsetstrref(char *str, Datum *pDatum);
 extern int dsetsubstr(const char *str, size_t len, Datum *pDatum);
+extern void dsetsubstrref(const char *str, size_t len, Datum *pDatum);
+extern int dsetsubsym(const char *str, size_t len, DSymTab *pTab, Datum *pDatum);
+extern int dsetsym(const char *str, DSymTab *pTab, Datum *pDatum);
 extern void dsetuint(ulong u, Datum *pDatum);
+extern size_t dstrlen(const Datum *pDatum);
 
 extern int dshquote(const char *str, Datum *pDatum);
+extern void dsymtabfree(DSymTab *pTab);
+extern void dsymtabinit(DSymTab *pTab);
 extern int dtos(Datum *pDest, const Datum *pSrc, const char *delim, ushort cflags);
-extern void dtrack(Datum *pDatum);
+extern int dtrack(Datum *pDatum);
 extern int dunputc(DFab *pFab);
+extern int dunshare(Datum *pDatum);
 extern void duntrack(Datum *pDatum);
 extern void dxfer(Datum *pDest, Datum *pSrc);
 
 // For internal use.
+extern DFab *bopentemp(DFab *pFab);
 extern int bputc(short c, DFab *pFab);
+extern int bputfab(DFab *pSrcFab, DFab *pFab, int rtnCode);
 extern int bputs(const char *str, DFab *pFab);
 #endif
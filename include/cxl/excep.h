@@ -36,7 +36,7 @@ typedef struct {
 #define ExExitMask	(ExExit | ExNoExit)	// Exit flags.
 
 // External variables.
-extern CXLExcep cxlExcep;
+extern __thread CXLExcep cxlExcep;		// Exception state of calling thread.
 
 // External function declarations.
 extern void eclear(void);
@@ -11,6 +11,10 @@
 #include "stdos.h"
 #include <stdio.h>
 
+// Forwards.
+struct Datum;
+struct DRope;
+
 // Definitions for fast data I/O routines.
 typedef struct {
 	int fileHandle;			// File handle/descriptor.
@@ -47,11 +51,13 @@ typedef struct {
 extern bool ffchomp(FastFile *pFastFile);
 extern int ffclose(FastFile *pFastFile);
 extern int ffclosekeep(FastFile *pFastFile);
+extern int ffencode(const struct Datum *pDatum, FastFile *pFastFile);
 extern int ffflush(FastFile *pFastFile);
 extern void fffree(FastFile *pFastFile);
 extern short ffgetc(FastFile *pFastFile);
 extern ssize_t ffgets(FastFile *pFastFile);
 extern FastFile *ffopen(const char *filename, short mode);
+extern int ffparse(struct Datum *pDatum, FastFile *pFastFile);
 extern int ffprintf(FastFile *pFastFile, const char *fmt, ...);
 extern int ffputc(short c, FastFile *pFastFile);
 extern int ffputs(const char *str, FastFile *pFastFile);
@@ -61,4 +67,5 @@ extern ssize_t ffslurp(FastFile *pFastFile);
 extern int ffputvizc(short c, ushort flags, FastFile *pFastFile);
 extern int ffputvizmem(const void *memPtr, size_t size, ushort flags, FastFile *pFastFile);
 extern int ffwrite(void *buf, size_t len, FastFile *pFastFile);
+extern int ffwriterope(const struct DRope *pRope, FastFile *pFastFile);
 #endif
@@ -14,14 +14,27 @@
 #include <stdint.h>
 #include "stdos.h"
 
+// Minimum size of buffer passed to inttos(), uinttos(), and realtos().
+#define NumBufSize		32
+
+// For internal use.  Macros for testing the eight bytes in a 64-bit word at once.  SwarLess() is non-zero if any byte is less
+// than n (which must be 128 or less), and SwarHas() is non-zero if any byte is equal to c.
+#define SwarOnes		0x0101010101010101ull
+#define SwarHighs		0x8080808080808080ull
+#define SwarLess(x, n)		(((x) - SwarOnes * (n)) & ~(x) & SwarHighs)
+#define SwarHas(x, c)		SwarLess((x) ^ (SwarOnes * (c)), 1)
+
 // External function declarations.
 extern int convDelim(const char *spec);
 extern char *cxlvers(void);
 extern int estrtol(const char *str, int base, long *pResult);
 extern int estrtoul(const char *str, int base, ulong *pResult);
 extern char *intf(long i);
+extern char *inttos(long i, char *dest);
 extern uint prime(uint n);
 extern uint32_t rand32(void);
 extern uint32_t rand32Uniform(uint32_t upperBound);
+extern char *realtos(double r, char *dest);
 extern char *uintf(ulong i);
+extern char *uinttos(ulong i, char *dest);
 #endif
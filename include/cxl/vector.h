@@ -0,0 +1,66 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// vector.h		Definitions and declarations for creating and managing packed numeric Vector objects.
+
+#ifndef vector_h
+#define vector_h
+
+#include "cxl/array.h"
+
+#define VecChunkSize	32		// Starting size of vector element chunks.
+#define VecSizeMax	(ArraySizeMax / 8)	// Maximum number of elements in a vector.
+
+// Flags for controlling function options (vflags).
+#define VOpInPlace	0x0001		// Perform operation on vector argument; otherwise, make new vector.
+
+// Comparison operators for element predicates.
+#define VCmpEQ		1		// Element == value.
+#define VCmpNE		2		// Element != value.
+#define VCmpLT		3		// Element < value.
+#define VCmpLE		4		// Element <= value.
+#define VCmpGT		5		// Element > value.
+#define VCmpGE		6		// Element >= value.
+
+// Element-wise arithmetic operators.
+#define VCalcAdd	1		// Element + operand.
+#define VCalcSub	2		// Element - operand.
+#define VCalcMul	3		// Element * operand.
+#define VCalcDiv	4		// Element / operand.
+
+// Vector object: a dynamic array of numbers of one type (dat_int, dat_uint, or dat_real), stored contiguously without Datum
+// object overhead.
+typedef struct {
+	DatumType type;			// Element type: dat_int (long), dat_uint (ulong), or dat_real (double).
+	ArraySize size;			// Number of elements allocated.
+	ArraySize used;			// Number of elements currently in use.
+	union {				// Elements (NULL if none allocated).
+		long *intNums;		// Signed integers.
+		ulong *uintNums;	// Unsigned integers.
+		double *realNums;	// Real numbers.
+		void *ptr;		// Generic pointer.
+		} u;
+	} Vector;
+
+// External function declarations.
+extern int vcalc(Vector *pVec1, ushort op, const Vector *pVec2);
+extern int vcalcn(Vector *pVec, ushort op, const Datum *pVal);
+extern void vclear(Vector *pVec);
+extern Vector *vclone(const Vector *pVec);
+extern ArraySize vcount(const Vector *pVec, ushort cmp, const Datum *pVal);
+extern Vector *vfilter(Vector *pVec, ushort cmp, const Datum *pVal, ushort vflags);
+extern void vfree(Vector *pVec);
+extern Vector *vfromarray(const Array *pArray, DatumType type);
+extern void vinit(Vector *pVec, DatumType type);
+extern void vmax(Datum *pDatum, const Vector *pVec);
+extern void vmean(Datum *pDatum, const Vector *pVec);
+extern void vmin(Datum *pDatum, const Vector *pVec);
+extern Vector *vnew(DatumType type, ArraySize len);
+extern int vpush(Vector *pVec, const Datum *pVal);
+extern int vput(const Vector *pVec, DFab *pFab, const char *delim, ushort cflags);
+extern void vsum(Datum *pDatum, const Vector *pVec);
+extern Array *vtoarray(const Vector *pVec);
+extern int vtos(Datum *pDatum, const Vector *pVec, const char *delim, ushort cflags);
+#endif
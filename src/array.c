@@ -20,12 +20,64 @@
 #include "cxl/array.h"
 #include "cxl/lib.h"
 #include <errno.h>
+#include <pthread.h>
 #include <string.h>
 #include <stdlib.h>
 
-// Global variables (used to detect if an array contains itself).
-static uint32_t arrayID = 0;			// Random ID number.
-static uint arrayNestLevel = 0;			// Array nesting level.
+// Array element buffer: holds the elements (Datum objects, stored contiguously) of one or more Array objects that share them by
+// reference count (copy on write).  The elements member of each Array object points to the first element, which follows the
+// header and "head" unused slots.  Unused slots are kept at the beginning of the buffer (as well as the end) so that elements can
+// be removed from and inserted at either end of an array in amortized constant time, which makes an array usable as a queue.
+typedef struct {
+	size_t refCount;			// Number of Array objects sharing elements.
+	Datum elements[];			// Elements.
+	} ArrayBuf;
+
+#define arrayBuf(pArray)	((ArrayBuf *) ((char *) ((pArray)->elements - (pArray)->head) - offsetof(ArrayBuf, elements)))
+
+// Hash index of array elements (for set operations): an open-addressing hash table which is used to find an element that is equal
+// to a given datum per deq() in expected constant time.  Elements are referenced by index instead of pointer because the array may
+// be grown (and its elements moved) while the index is in use.
+typedef struct {
+	size_t hash;				// Hash of element.
+	ArraySize index;			// Element index plus one, or zero if slot is empty.
+	} IndexSlot;
+
+typedef struct {
+	const Array *pArray;			// Array being indexed.
+	IndexSlot *slots;			// Hash table.
+	size_t mask;				// Number of slots (a power of 2) minus one.
+	ushort aflags;				// Comparison flag (AOpIgnore).
+	} ArrayIndex;
+
+// Array sorting parameters.
+#define SortRunSize	16		// Length of runs that are sorted by insertion before merging begins.
+#define SortParMin	32768		// Minimum number of elements to sort with multiple threads.
+#define SortMaxThreads	8		// Maximum number of threads to use for one sort (a power of 2).
+
+// Sort control object: comparison method used by all threads of one sort.
+typedef struct {
+	int (*cmp)(const Datum *pDatum1, const Datum *pDatum2);	// Caller's comparison routine, or NULL to use dcmp().
+	ushort dflags;				// Flags for dcmp() (DOpIgnore).
+	} SortCtrl;
+
+// Sort task: the portion of a parallel sort performed by one thread.  A task either sorts one run in place or produces the
+// part of the merge of two adjacent runs that begins at output element outBeg and ends before output element outEnd.
+typedef struct {
+	const SortCtrl *pCtrl;			// Comparison method.
+	bool merge;				// Merge task, otherwise sort task.
+	Datum *pSrc;				// First run.
+	Datum *pDest;				// Merge destination, or work area (sort task).
+	ArraySize len1;				// Length of first run.
+	ArraySize len2;				// Length of second run, which immediately follows the first (merge task).
+	ArraySize outBeg, outEnd;		// Range of merge output (merge task).
+	pthread_t thread;			// Thread performing task.
+	bool started;				// Thread was started.
+	} SortTask;
+
+// Thread-local variables (used to detect if an array contains itself).
+static __thread uint32_t arrayID = 0;		// Random ID number.
+static __thread uint arrayNestLevel = 0;	// Array nesting level.
 
 // Initialize an Array object as an empty array.
 void ainit(Array *pArray) {
@@ -33,16 +85,20 @@ void ainit(Array *pArray) {
 	*pArray = (Array) {NULL};	// Set contents to zero.
 	}
 
-// Clear an array: free element storage (if any) and set used size to zero.
+// Clear an array: release element storage (if any) and set used size to zero.  The elements are freed only if they are not
+// shared with another array.
 void aclear(Array *pArray) {
-	Datum **ppArrayEl = pArray->elements;
-	if(ppArrayEl != NULL) {
-		Datum **ppArrayElEnd = ppArrayEl + pArray->used;
-		while(ppArrayEl < ppArrayElEnd)
-			dfree(*ppArrayEl++);
-		free((void *) pArray->elements);
-		}
-	pArray->used = pArray->size = 0;
+	Datum *pArrayEl = pArray->elements;
+	if(pArrayEl != NULL) {
+		ArrayBuf *pArrayBuf = arrayBuf(pArray);
+		if(__atomic_sub_fetch(&pArrayBuf->refCount, 1, __ATOMIC_ACQ_REL) == 0) {
+			Datum *pArrayElEnd = pArrayEl + pArray->used;
+			while(pArrayEl < pArrayElEnd)
+				dclear(pArrayEl++);
+			free((void *) pArrayBuf);
+			}
+		}
+	pArray->used = pArray->size = pArray->head = 0;
 	pArray->elements = NULL;
 	}
 
@@ -70,18 +126,26 @@ void afree(Array *pArray) {
 	}
 
 // Plug nil values into array slot(s), given index and length.  It is assumed that all slots have been allocated and are
-// available for reassignment.  Return status code.
-static int plugNil(Array *pArray, ArraySize index, ArraySize len) {
-
-	if(len > 0) {
-		Datum **ppArrayEl = pArray->elements + index;
-		Datum **ppArrayElEnd = ppArrayEl + len;
-		do {
-			if(dnew(ppArrayEl++) != 0)
-				return -1;
-			} while(ppArrayEl < ppArrayElEnd);
+// available for reassignment.
+static void plugNil(Array *pArray, ArraySize index, ArraySize len) {
+	Datum *pArrayEl = pArray->elements + index;
+	Datum *pArrayElEnd = pArrayEl + len;
+
+	while(pArrayEl < pArrayElEnd) {
+		dinit(pArrayEl);
+		pArrayEl++->flags = DFElement;
 		}
-	return 0;
+	}
+
+// Move the elements of an array (in place) by given number of slots toward the end of the element buffer (or toward the beginning
+// if negative).  It is assumed that the slots exist.
+static void slide(Array *pArray, ArraySize offset) {
+
+	if(pArray->used > 0)
+		memmove((void *) (pArray->elements + offset), (void *) pArray->elements, pArray->used * sizeof(Datum));
+	pArray->elements += offset;
+	pArray->head += offset;
+	pArray->size -= offset;
 	}
 
 // Check if array needs to grow so that it contains given array index (which mandates that array contain at least index + 1
@@ -113,7 +177,19 @@ TooMuch:
 		minSize = index + 1;
 		}
 
-	// Expansion needed.  Increase old size until it's big enough, without causing an integer overflow.
+	// Expansion needed.  If there are unused slots at the beginning of the buffer, shift the elements there first.  This is
+	// sufficient if the unused slots are at least as numerous as the elements (so that the cost of shifting them is repaid
+	// by the number of elements that were removed from the beginning of the array to create the slots); otherwise, the buffer
+	// is grown as well.
+	if(pArray->head > 0) {
+		bool reclaim = pArray->head >= pArray->used && pArray->head + pArray->size >= minSize;
+
+		slide(pArray, -pArray->head);
+		if(reclaim)
+			goto CheckFill;
+		}
+
+	// Increase old size until it's big enough, without causing an integer overflow.
 	ArraySize newSize = pArray->size;
 	do {
 		newSize = (newSize == 0) ? ArrayChunkSize : (newSize < ArrayChunkSize * 4) ? newSize * 2 :
@@ -121,16 +197,20 @@ TooMuch:
 		} while(newSize < minSize);
 
 	// Get more space.
-	if((pArray->elements = (Datum **) realloc((void *) pArray->elements, newSize * sizeof(Datum *))) == NULL) {
+	ArrayBuf *pArrayBuf = (ArrayBuf *) realloc(pArray->elements == NULL ? NULL : (void *) arrayBuf(pArray),
+	 sizeof(ArrayBuf) + newSize * sizeof(Datum));
+	if(pArrayBuf == NULL) {
 		cxlExcep.flags |= ExcepMem;
 		return emsgf(-1, "%s, allocating %ld-element array", strerror(errno), newSize);
 		}
+	if(pArray->elements == NULL)
+		pArrayBuf->refCount = 1;
+	pArray->elements = pArrayBuf->elements;
 	pArray->size = newSize;
 CheckFill:
 	if(aflags & AOpFill) {
 		// Set new elements to nil and increase "used" size.
-		if(plugNil(pArray, pArray->used, growSize) != 0)
-			return -1;
+		plugNil(pArray, pArray->used, growSize);
 		pArray->used += growSize;
 		}
 
@@ -174,47 +254,76 @@ IndexErr:
 	return 0;
 	}
 
-// Open slot in an array at given index by shifting higher elements to the right one position (so that a value can be inserted
-// there by the caller).  If AOpCopy flag is set, set slot to a nil value.  Update "used" size and return status code.  Index is
-// assumed to be less than or equal to used size.
-static int spread(Array *pArray, ArraySize index, ushort aflags) {
+// Open one or more contiguous slots in an array at given index by shifting lower elements to the left (if there are fewer of them
+// and enough unused slots precede them or can be created) or higher elements to the right (so that values can be inserted there
+// by the caller).  Update "used" size and return status code.  Index is assumed to be less than or equal to used size.
+static int spread(Array *pArray, ArraySize index, ArraySize len) {
+
+	if(index < pArray->used - index && (pArray->head >= len || index == 0)) {
+		if(pArray->head < len) {
+
+			// Not enough unused slots at beginning of buffer.  Create as many as there are elements (but at least
+			// ArrayChunkSize and len) by shifting the elements to the right, so that repeated insertion at the
+			// beginning of the array takes amortized constant time.
+			ArraySize gap = pArray->used < ArrayChunkSize ? ArrayChunkSize : pArray->used;
+			if(gap < len)
+				gap = len;
+			if(need(pArray, gap, -1, 0) != 0)
+				return -1;
+			slide(pArray, gap);
+			}
 
-	if(need(pArray, 1, -1, 0) != 0)					// Ensure a slot exists at end of used portion.
-		return -1;
-	if(index < pArray->used) {					// If not inserting at end of array...
-		Datum **ppArrayEl0, **ppArrayEl1;
+		// 012345678	012345678	index = 2, len = 1
+		// ..abcdef.	.ab.cdef.
+		//   0 1
+		if(index > 0)							// If not inserting at beginning of array...
+			memmove((void *) (pArray->elements - len),		// shift elements to the left.
+			 (void *) pArray->elements, index * sizeof(Datum));
+		pArray->elements -= len;
+		pArray->head -= len;
+		pArray->size += len;
+		}
+	else {
+		if(need(pArray, len, -1, 0) != 0)			// Ensure slots exist at end of used portion.
+			return -1;
+		if(index < pArray->used)				// If not inserting at end of array...
 
-		// 012345678	012345678	index = 1
-		// abcdef...	a.bcdef..
-		//  0    1
-		ppArrayEl0 = pArray->elements + index;			// set slot pointers...
-		ppArrayEl1 = pArray->elements + pArray->used;
-		do {							// and shift elements to the right.
-			ppArrayEl1[0] = ppArrayEl1[-1];
-			} while(--ppArrayEl1 > ppArrayEl0);
+			// 012345678	012345678	index = 1, len = 1
+			// abcdef...	a.bcdef..
+			//  0    1
+			memmove((void *) (pArray->elements + index + len),	// shift elements to the right.
+			 (void *) (pArray->elements + index), (pArray->used - index) * sizeof(Datum));
 		}
-	++pArray->used;							// Bump "used" size...
-	return (aflags & AOpCopy) ? plugNil(pArray, index, 1) : 0;	// and set slot to nil if requested.
+	pArray->used += len;						// Bump "used" size.
+	return 0;
 	}
 
 // Remove one or more contiguous elements from an array at given location.  It is assumed that the Datum object(s) in the slice
-// have already been saved or freed and that "index" and "len" are in range.
+// have already been saved or cleared and that "index" and "len" are in range.
 static void shrink(Array *pArray, ArraySize index, ArraySize len) {
 
 	if(len > 0) {
-		if(index + len < pArray->used) {					// Slice at end of array?
-			Datum **ppArrayEl0, **ppArrayEl1, **ppArrayEl2;			// No, close the gap.
+		if(index < pArray->used - index - len) {				// Fewer elements before slice?
 
 			// 01234567	01234567	index = 1, len = 3
-			// abcdef..	aef.....
+			// abcdef..	...aef..
 			//  0  1   2
-			ppArrayEl1 = (ppArrayEl0 = pArray->elements + index) + len;	// Set slot pointers...
-			ppArrayEl2 = pArray->elements + pArray->size;
-			do {								// and shift elements to the left.
-				*ppArrayEl0++ = *ppArrayEl1++;
-				} while(ppArrayEl1 < ppArrayEl2);
+			if(index > 0)							// Yes, close the gap from the left.
+				memmove((void *) (pArray->elements + len), (void *) pArray->elements,
+				 index * sizeof(Datum));
+			pArray->elements += len;
+			pArray->head += len;
+			pArray->size -= len;
 			}
-		pArray->used -= len;							// Update "used" length.
+		else if(index + len < pArray->used)					// Slice at end of array?
+
+			// 01234567	01234567	index = 4, len = 1
+			// abcdef..	abcdf...
+			//     012
+			memmove((void *) (pArray->elements + index),			// No, close the gap from the right.
+			 (void *) (pArray->elements + index + len), (pArray->used - index - len) * sizeof(Datum));
+		if((pArray->used -= len) == 0 && pArray->head > 0)			// Update "used" length.
+			slide(pArray, -pArray->head);					// Start over at beginning if empty.
 		}
 	}
 
@@ -222,46 +331,71 @@ static void shrink(Array *pArray, ArraySize index, ArraySize len) {
 // given datum.  Ignore case in string comparisons if AOpIgnore flag set.  Index is assumed to be non-negative and less than or
 // equal to array length.  Return index if matching element found, otherwise -1.
 static ArraySize scan(const Array *pArray, ArraySize index, const Datum *pVal, ushort aflags) {
-	Datum **ppArrayEl, **ppArrayElEnd;
+	Datum *pArrayEl, *pArrayElEnd;
 
-	ppArrayElEnd = (ppArrayEl = pArray->elements) + index;
+	pArrayElEnd = (pArrayEl = pArray->elements) + index;
 	index = -1;
-	while(ppArrayEl < ppArrayElEnd) {
-		if(deq(*ppArrayEl, pVal, aflags & AOpIgnore)) {
-			index = ppArrayEl - pArray->elements;
+	while(pArrayEl < pArrayElEnd) {
+		if(deq(pArrayEl, pVal, aflags & AOpIgnore)) {
+			index = pArrayEl - pArray->elements;
 			if(!(aflags & AOpLast))
 				break;
 			}
-		++ppArrayEl;
+		++pArrayEl;
 		}
 	return index;
 	}
 
-// Delete all elements in array that match given datum and return number of elements deleted.  Ignore case in string comparisons
-// if AOpIgnore flag set.
+// Delete all elements in array that match given datum and return number of elements deleted, or -1 if error.  Ignore case in
+// string comparisons if AOpIgnore flag set.  The datum may be an element of the array, in which case it is copied first.
 static ArraySize deleteif(Array *pArray, const Datum *pVal, ushort aflags) {
 	ArraySize count = 0;
 
 	if(pArray->used > 0) {
-		Datum **ppArrayEl0, **ppArrayEl1, **ppArrayElEnd;
+		Datum *pArrayEl0, *pArrayEl1, *pArrayElEnd;
+		Datum val;
 
-		ppArrayElEnd = (ppArrayEl0 = ppArrayEl1 = pArray->elements) + pArray->used;
+		dinit(&val);
+		if(aunshare(pArray) != 0)
+			return -1;
+		pArrayElEnd = (pArrayEl0 = pArrayEl1 = pArray->elements) + pArray->used;
+		if(pVal >= pArrayEl0 && pVal < pArrayElEnd) {
+			if(dcpy(&val, pVal) != 0)
+				return -1;
+			pVal = &val;
+			}
 		do {
-			if(deq(*ppArrayEl1, pVal, aflags & AOpIgnore)) {	// Match?
-				dfree(*ppArrayEl1);				// Yes, delete element...
+			if(deq(pArrayEl1, pVal, aflags & AOpIgnore)) {		// Match?
+				dclear(pArrayEl1);				// Yes, delete element...
 				++count;					// and count it.
 				}
-			else if(ppArrayEl1 == ppArrayEl0)
-				++ppArrayEl0;					// No, skip over it...
+			else if(pArrayEl1 == pArrayEl0)
+				++pArrayEl0;					// No, skip over it...
 			else
-				*ppArrayEl0++ = *ppArrayEl1;			// or shift it left.
-			} while(++ppArrayEl1 < ppArrayElEnd);
+				*pArrayEl0++ = *pArrayEl1;			// or shift it left.
+			} while(++pArrayEl1 < pArrayElEnd);
 
-		pArray->used = ppArrayEl0 - pArray->elements;			// Update "used" length.
+		pArray->used = pArrayEl0 - pArray->elements;			// Update "used" length.
+		dclear(&val);
 		}
 	return count;
 	}
 
+// Copy a datum to an element of an array that cannot be reached from the datum (such as a new array), sharing the elements of an
+// array value instead of cloning them.  Return status code.
+static int elcpy(Datum *pDest, const Datum *pSrc) {
+
+	if(pSrc->type == dat_array) {
+		Array *pArray;
+
+		if((pArray = ashare(pSrc->u.pArray)) == NULL)
+			return -1;
+		dadoptarray(pArray, pDest);
+		return 0;
+		}
+	return dcpy(pDest, pSrc);
+	}
+
 // Create an array (in heap space) and return pointer to it, or NULL if error.  If len > 0, pre-allocate that number of elements
 // and, if AOpFill flag is set, set them to nil (or *pVal if pVal not NULL); otherwise, leave undefined.
 static Array *create(ArraySize len, const Datum *pVal, ushort aflags) {
@@ -282,9 +416,9 @@ static Array *create(ArraySize len, const Datum *pVal, ushort aflags) {
 		if(need(pArray, 0, len - 1, aflags) != 0)
 			return NULL;
 		if(pVal != NULL) {
-			Datum **ppArrayEl = pArray->elements;
+			Datum *pArrayEl = pArray->elements;
 			do {
-				if(dcpy(*ppArrayEl++, pVal) != 0)
+				if(elcpy(pArrayEl++, pVal) != 0)
 					return NULL;
 				} while(--len > 0);
 			}
@@ -292,6 +426,54 @@ static Array *create(ArraySize len, const Datum *pVal, ushort aflags) {
 	return pArray;							// and return it.
 	}
 
+// Create an array that shares the elements of given array and return pointer to it, or NULL if error.  Neither array is copied
+// until one of them is modified, at which time aunshare() is called to give it its own elements (copy on write).
+Array *ashare(const Array *pArray) {
+	Array *pArray1;
+
+	if((pArray1 = create(0, NULL, 0)) != NULL && pArray->used > 0) {
+		__atomic_add_fetch(&arrayBuf(pArray)->refCount, 1, __ATOMIC_RELAXED);
+		pArray1->size = pArray->size;
+		pArray1->used = pArray->used;
+		pArray1->head = pArray->head;
+		pArray1->elements = pArray->elements;
+		}
+	return pArray1;
+	}
+
+// Prepare an array to be modified; that is, copy its elements if they are shared with any other array so that they are not.
+// Array values in the elements are shared with the originals in turn.  Return status code.
+int aunshare(Array *pArray) {
+	Datum *pArrayEl = pArray->elements;
+
+	if(pArrayEl != NULL && __atomic_load_n(&arrayBuf(pArray)->refCount, __ATOMIC_ACQUIRE) > 1) {
+		Array array;
+		Datum *pArrayEl1, *pArrayElEnd = pArrayEl + pArray->used;
+
+		// Copy elements to new element buffer...
+		ainit(&array);
+		if(need(&array, pArray->used, -1, AOpFill) != 0)
+			goto ErrRetn;
+		pArrayEl1 = array.elements;
+		while(pArrayEl < pArrayElEnd)
+			if(elcpy(pArrayEl1++, pArrayEl++) != 0)
+				goto ErrRetn;
+
+		// release shared one...
+		aclear(pArray);
+
+		// and substitute copy.
+		pArray->size = array.size;
+		pArray->used = array.used;
+		pArray->elements = array.elements;
+		return 0;
+ErrRetn:
+		aclear(&array);
+		return -1;
+		}
+	return 0;
+	}
+
 // Create an array by calling create() with AOpFill flag.
 Array *anew(ArraySize len, const Datum *pVal) {
 
@@ -312,23 +494,40 @@ bool ainclude(const Array *pArray, const Datum *pVal, ushort aflags) {
 	return scan(pArray, pArray->used, pVal, aflags & AOpIgnore) >= 0;
 	}
 
-// Delete all elements in array equal to datum and return deletion count.  If AOpIgnore flag is set, case in string comparisons
-// is ignored.
+// Delete all elements in array equal to datum and return deletion count, or -1 if error.  If AOpIgnore flag is set, case in
+// string comparisons is ignored.
 ArraySize adeleteif(Array *pArray, const Datum *pVal, ushort aflags) {
 
 	return deleteif(pArray, pVal, aflags & AOpIgnore);
 	}
 
-// Insert a Datum object (or a copy if AOpCopy flag is set) into an array at given index position.  Return status code.
+// Insert a Datum object's value (or a copy if AOpCopy flag is set) into an array at given index position.  If the value is not
+// copied, it is moved and the (heap) Datum object is freed.  Return status code.  The copy is made before the array is unshared
+// and grown, so that the datum may be an element of the array or a copy of the array itself.
 static int put(Array *pArray, ArraySize index, Datum *pDatum, ushort aflags) {
+	Datum datum, *pArrayEl;
 
-	if(spread(pArray, index, aflags) != 0)
-		return -1;
-	if(!(aflags & AOpCopy))
-		pArray->elements[index] = pDatum;
-	else if(dcpy(pArray->elements[index], pDatum) != 0)
-		return -1;
+	if(aflags & AOpCopy) {
+		dinit(&datum);
+		if(dcpy(&datum, pDatum) != 0)
+			goto ErrRetn;
+		}
+	if(aunshare(pArray) != 0 || spread(pArray, index, 1) != 0)
+		goto ErrRetn;
+	pArrayEl = pArray->elements + index;
+	if(aflags & AOpCopy)
+		*pArrayEl = datum;
+	else {
+		*pArrayEl = *pDatum;
+		dsetnilval(pDatum);
+		dfree(pDatum);
+		}
+	pArrayEl->flags = DFElement;
 	return 0;
+ErrRetn:
+	if(aflags & AOpCopy)
+		dclear(&datum);
+	return -1;
 	}
 
 // Return copy of *pArray excluding nil elements, or if AOpInPlace flag set, remove nil elements from *pArray, shift elements
@@ -342,19 +541,20 @@ Array *acompact(Array *pArray, ushort aflags) {
 
 		pArrayTarg = pArray;
 		dinit(&datum);
-		(void) deleteif(pArrayTarg, &datum, 0);
+		if(deleteif(pArrayTarg, &datum, 0) < 0)
+			return NULL;
 		}
 	else {
 		// Copy non-nil elements to new array.
-		Datum **ppArrayEl, **ppArrayElEnd;
-		ppArrayElEnd = (ppArrayEl = pArray->elements) + pArray->used;
+		Datum *pArrayEl, *pArrayElEnd;
+		pArrayElEnd = (pArrayEl = pArray->elements) + pArray->used;
 		if((pArrayTarg = create(0, NULL, 0)) == NULL)
 			return NULL;
-		while(ppArrayEl < ppArrayElEnd) {
-			if((*ppArrayEl)->type != dat_nil)
-				if(put(pArrayTarg, pArrayTarg->used, *ppArrayEl, AOpCopy) != 0)
+		while(pArrayEl < pArrayElEnd) {
+			if(pArrayEl->type != dat_nil)
+				if(put(pArrayTarg, pArrayTarg->used, pArrayEl, AOpCopy) != 0)
 					return NULL;
-			++ppArrayEl;
+			++pArrayEl;
 			}
 		}
 
@@ -365,9 +565,13 @@ Array *acompact(Array *pArray, ushort aflags) {
 // selected from the end of the array such that the last element is -1, the second-to-last is -2, etc.; otherwise, elements are
 // selected from the beginning with the first being 0.  If the index is zero or positive and the AOpGrow flag is set, the array
 // will be enlarged if necessary to satisfy the request.  Any array elements that are created are set to nil values.  Otherwise,
-// the referenced element must already exist.
+// the referenced element must already exist.  The array is unshared first, so that the element may be modified by the caller,
+// unless the AOpConst flag is set (and AOpGrow is not), in which case the caller must not modify it.  The pointer returned is
+// valid until the array is next grown, shrunk, or unshared.
 Datum *aget(Array *pArray, ArraySize index, ushort aflags) {
 
+	if((!(aflags & AOpConst) || (aflags & AOpGrow)) && aunshare(pArray) != 0)
+		return NULL;
 	if(index < 0) {
 		if(-index > pArray->used)
 			goto NoSuch;
@@ -383,34 +587,34 @@ NoSuch:
 	else if(need(pArray, 0, index, AOpFill) != 0)
 		return NULL;
 
-	return pArray->elements[index];
+	return pArray->elements + index;
 	}
 
 // Create an array from a slice of given array and return it (or NULL if error), given signed index and length.  Length may be
 // large to select all elements from index to end of array.  If AOpCut flag is set, transfer sliced elements to new array and
-// close the gap; otherwise, copy them.
+// close the gap; otherwise, copy them (sharing any array values, unless AOpCloneAll flag is set).
 Array *aslice(Array *pArray, ArraySize index, ArraySize len, ushort aflags) {
 	Array *pArray1;
 
 	// If cutting elements, move them into new array; otherwise, copy them (to nil slots).
-	if(normalize(pArray, &index, &len, AOpRemaining) != 0 ||
+	if(normalize(pArray, &index, &len, AOpRemaining) != 0 || ((aflags & AOpCut) && aunshare(pArray) != 0) ||
 	 (pArray1 = create(len, NULL, aflags & AOpCut ? 0 : AOpFill)) == NULL)
 		return NULL;
 	if(len > 0) {
-		Datum **ppArrayEl = pArray->elements + index;
-		Datum **ppArrayElEnd = ppArrayEl + len;
-		Datum **ppArrayEl1 = pArray1->elements;
+		Datum *pArrayEl = pArray->elements + index;
+		Datum *pArrayElEnd = pArrayEl + len;
+		Datum *pArrayEl1 = pArray1->elements;
 		do {
 			if(aflags & AOpCut)
-				*ppArrayEl1 = *ppArrayEl;
-			else if((*ppArrayEl)->type == dat_arrayRef && (aflags & AOpCloneAll)) {
-				if(dsetarray((*ppArrayEl)->u.pArray, *ppArrayEl1) != 0)
+				*pArrayEl1 = *pArrayEl;
+			else if(pArrayEl->type == dat_arrayRef && (aflags & AOpCloneAll)) {
+				if(dsetarray(pArrayEl->u.pArray, pArrayEl1) != 0)
 					return NULL;
 				}
-			else if(dcpy(*ppArrayEl1, *ppArrayEl) != 0)
+			else if((aflags & AOpCloneAll ? dcpy(pArrayEl1, pArrayEl) : elcpy(pArrayEl1, pArrayEl)) != 0)
 				return NULL;
-			++ppArrayEl1;
-			} while(++ppArrayEl < ppArrayElEnd);
+			++pArrayEl1;
+			} while(++pArrayEl < pArrayElEnd);
 		if(aflags & AOpCut)
 			pArray1->used = len;
 		}
@@ -438,14 +642,11 @@ Array *aclone(const Array *pArray) {
 		return NULL;
 		}
 
-	// Set array ID and clone array via aslice().
+	// Set array ID, clone array via aslice(), and clear ID (so that a shared subarray can be cloned again via another path).
 	++arrayNestLevel;
 	((Array *) pArray)->id = arrayID;
-	if((pArray1 = aslice((Array *) pArray, 0, pArray->used, AOpCloneAll)) == NULL) {
-		--arrayNestLevel;
-		return NULL;
-		}
-
+	pArray1 = aslice((Array *) pArray, 0, pArray->used, AOpCloneAll);
+	((Array *) pArray)->id = 0;
 	--arrayNestLevel;
 	return pArray1;
 	}
@@ -454,33 +655,47 @@ Array *aclone(const Array *pArray) {
 // array if AOpGrow flag is set.
 int afill(Array *pArray, const Datum *pVal, ArraySize index, ArraySize len, ushort aflags) {
 
-	if(normalize(pArray, &index, &len, aflags & AOpGrow) != 0)
+	if(normalize(pArray, &index, &len, aflags & AOpGrow) != 0 || aunshare(pArray) != 0)
 		return -1;
 	if(len > 0) {
-		Datum **ppArrayEl, **ppArrayElEnd;
+		Datum *pArrayEl, *pArrayElEnd;
+		Datum val;
 
+		// Copy value first if it is an element of the array, which may be moved when the array is grown.
+		dinit(&val);
+		if(pVal >= pArray->elements && pVal < pArray->elements + pArray->used) {
+			if(dcpy(&val, pVal) != 0)
+				return -1;
+			pVal = &val;
+			}
 		if(index + len > pArray->used)
 			if(need(pArray, 0, index + len - 1, AOpFill) != 0)
-				return -1;
-		ppArrayElEnd = (ppArrayEl = pArray->elements + index) + len;
+				goto ErrRetn;
+		pArrayElEnd = (pArrayEl = pArray->elements + index) + len;
 		do {
-			if(dcpy(*ppArrayEl++, pVal) != 0)
-				return -1;
-			} while(ppArrayEl < ppArrayElEnd);
+			if(dcpy(pArrayEl++, pVal) != 0)
+				goto ErrRetn;
+			} while(pArrayEl < pArrayElEnd);
+		dclear(&val);
+		return 0;
+ErrRetn:
+		dclear(&val);
+		return -1;
 		}
 
 	return 0;
 	}
 
-// Remove a Datum object from an array at given index, shrink array by one, and return removed element.  If no elements left,
-// return NULL.
+// Remove an element from an array at given index, shrink array by one, and return removed value in a new (untracked) Datum
+// object, which the caller is responsible for freeing.  If no elements left or error, return NULL.
 static Datum *cut(Array *pArray, ArraySize index) {
+	Datum *pDatum;
 
-	if(pArray->used == 0)
+	if(pArray->used == 0 || aunshare(pArray) != 0 || dnew(&pDatum) != 0)
 		return NULL;
 
-	// Grab element, abandon slot, and return it.
-	Datum *pDatum = pArray->elements[index];
+	// Move element to new Datum object, abandon slot, and return it.
+	dxfer(pDatum, pArray->elements + index);
 	shrink(pArray, index, 1);
 	return pDatum;
 	}
@@ -498,6 +713,13 @@ int apush(Array *pArray, Datum *pVal, ushort aflags) {
 	return put(pArray, pArray->used, pVal, aflags & AOpCopy);
 	}
 
+// Append "count" Datum objects (or copies if AOpCopy flag set) to an array, given array of pointers to them, growing the array
+// at most once.  Return status code.
+int apushv(Array *pArray, Datum **vals, ArraySize count, ushort aflags) {
+
+	return asplice(pArray, pArray->used, 0, vals, count, aflags & AOpCopy);
+	}
+
 // Remove a Datum object from beginning of an array, shrink array by one, and return removed element.  If no elements left,
 // return NULL.
 Datum *ashift(Array *pArray) {
@@ -531,32 +753,101 @@ int ainsert(Array *pArray, Datum *pVal, ArraySize index, ushort aflags) {
 	return put(pArray, index + i, pVal, aflags & AOpCopy);
 	}
 
+// Replace a slice of an array, given signed index (which may be equal to "used" size) and length, with "count" Datum objects (or
+// copies if AOpCopy flag set), given array of pointers to them, and return status code.  If the values are not copied, they are
+// moved and the (heap) Datum objects are freed.  The deleted elements are cleared.  A negative length or one that extends past the
+// end of the array selects all remaining elements.  The array is grown at most once and the elements following (or preceding)
+// the slice are shifted at most once, so that any number of elements can be inserted and deleted in time proportional to their
+// number plus the array length.  The copies are made before the array is modified, so that any value may be an element of the
+// array or a copy of the array itself.
+int asplice(Array *pArray, ArraySize index, ArraySize len, Datum **vals, ArraySize count, ushort aflags) {
+	Datum *pDatum, *pArrayEl, *pArrayElEnd;
+	Datum *copies = NULL;
+	ArraySize i;
+
+	if(count < 0)
+		return emsgf(-1, "Invalid value count (%ld)", count);
+	if(index == pArray->used)
+		len = 0;
+	else if(normalize(pArray, &index, &len, AOpRemaining) != 0)
+		return -1;
+
+	// Copy values if requested.
+	if((aflags & AOpCopy) && count > 0) {
+		if((copies = (Datum *) malloc(count * sizeof(Datum))) == NULL) {
+			cxlExcep.flags |= ExcepMem;
+			return emsgsys(-1);
+			}
+		for(i = 0; i < count; ++i) {
+			dinit(copies + i);
+			if(dcpy(copies + i, vals[i]) != 0) {
+				++i;
+				goto ErrRetn;
+				}
+			}
+		}
+
+	// Make room for values if more are being inserted than deleted.
+	if(aunshare(pArray) != 0 || (count > len && spread(pArray, index + len, count - len) != 0))
+		goto ErrRetn;
+
+	// Clear deleted elements and close any remaining gap.
+	pArrayElEnd = (pArrayEl = pArray->elements + index) + len;
+	while(pArrayEl < pArrayElEnd)
+		dclear(pArrayEl++);
+	if(count < len)
+		shrink(pArray, index + count, len - count);
+
+	// Store values.
+	pArrayEl = pArray->elements + index;
+	for(i = 0; i < count; ++i) {
+		if(copies != NULL)
+			*pArrayEl = copies[i];
+		else {
+			*pArrayEl = *(pDatum = vals[i]);
+			dsetnilval(pDatum);
+			dfree(pDatum);
+			}
+		pArrayEl++->flags = DFElement;
+		}
+	free((void *) copies);
+	return 0;
+ErrRetn:
+	if(copies != NULL) {
+		while(i > 0)
+			dclear(copies + --i);
+		free((void *) copies);
+		}
+	return -1;
+	}
+
 // Step through an array, returning each element in sequence, or NULL if none left.  "ppArray" is an indirect pointer to the
-// array object and is modified by this routine.
+// array object and is modified by this routine.  The array is unshared first (which copies its elements if they are shared) so
+// that the elements may be modified by the caller.
 Datum *aeach(Array **ppArray) {
-	static struct {
-		Datum **ppArrayEl, **ppArrayElEnd;
+	static __thread struct {
+		Datum *pArrayEl, *pArrayElEnd;
 		} arrayState = {
 			NULL, NULL
 			};
 
 	// Validate and initialize control pointers.
 	if(*ppArray != NULL) {
-		if((*ppArray)->size == 0)
+		if((*ppArray)->size == 0 || aunshare(*ppArray) != 0)
 			goto Done;
-		arrayState.ppArrayElEnd = (arrayState.ppArrayEl = (*ppArray)->elements) + (*ppArray)->used;
+		arrayState.pArrayElEnd = (arrayState.pArrayEl = (*ppArray)->elements) + (*ppArray)->used;
 		*ppArray = NULL;
 		}
-	else if(arrayState.ppArrayEl == NULL)
+	else if(arrayState.pArrayEl == NULL)
 		return NULL;
 
 	// Get next element and return it, or NULL if none left.
-	if(arrayState.ppArrayEl == arrayState.ppArrayElEnd) {
+	if(arrayState.pArrayEl == arrayState.pArrayElEnd) {
 Done:
-		arrayState.ppArrayEl = NULL;
+		arrayState.pArrayEl = NULL;
 		return NULL;
 		}
-	return *arrayState.ppArrayEl++;
+	return arrayState.pArrayEl++;
 	}
 
 // Split a string into an array using given field delimiter and limit value.  Substrings are separated by a single character,
@@ -576,8 +867,9 @@ Done:
 //	> 0		Maximum number of array elements to return.  The last element of the array will contain embedded
 //			delimiter(s) if the number of delimiters in the string is equal to or greater than the "limit" value.
 //
+// Each element is set to a copy of its substring, or to a substring reference (type dat_substrRef) into src if byRef is true.
 // Routine saves results in a new array and returns a pointer to the object, or NULL if error.
-Array *asplit(short delim, const char *src, int limit) {
+static Array *strSplit(short delim, const char *src, int limit, bool byRef) {
 	Array *pArray;
 
 	// Create an empty array.
@@ -658,7 +950,11 @@ Array *asplit(short delim, const char *src, int limit) {
 				}
 
 			// Push substring onto array.
-			if((pDatum = aget(pArray, pArray->used, AOpGrow)) == NULL || dsetsubstr(str0, len, pDatum) != 0)
+			if((pDatum = aget(pArray, pArray->used, AOpGrow)) == NULL)
+				return NULL;
+			if(byRef)
+				dsetsubstrref(str0, len, pDatum);
+			else if(dsetsubstr(str0, len, pDatum) != 0)
 				return NULL;
 
 			// Onward.
@@ -672,6 +968,21 @@ Done:
 	return pArray;
 	}
 
+// Split a string into an array of substrings (copied) using given field delimiter and limit value, as described for strSplit().
+// Return pointer to new array, or NULL if error.
+Array *asplit(short delim, const char *src, int limit) {
+
+	return strSplit(delim, src, limit, false);
+	}
+
+// Split a string into an array of substring references using given field delimiter and limit value, as described for
+// strSplit().  No substrings are copied, so src must remain valid for the life of the array.  Return pointer to new array, or
+// NULL if error.
+Array *asplitref(short delim, const char *src, int limit) {
+
+	return strSplit(delim, src, limit, true);
+	}
+
 // Compare one array to another and return true if they are identical, otherwise false.  Ignore case in string comparisons if
 // AOpIgnore flag set.  Also, treat an array that contains itself as unequal to any other.
 bool aeq(const Array *pArray1, const Array *pArray2, ushort aflags) {
@@ -680,7 +991,7 @@ bool aeq(const Array *pArray1, const Array *pArray2, ushort aflags) {
 	// Do sanity checks.
 	if(size != pArray2->used)
 		return false;
-	if(size == 0 || pArray1 == pArray2)
+	if(size == 0 || pArray1 == pArray2 || pArray1->elements == pArray2->elements)
 		return true;
 
 	// Both arrays have at least one element and the same number.  Generate new array ID if at top level.
@@ -691,20 +1002,23 @@ bool aeq(const Array *pArray1, const Array *pArray2, ushort aflags) {
 	if(pArray1->id == arrayID || pArray2->id == arrayID)
 		return false;
 
-	// We're good.  Save ID in both arrays and compare them.
+	// We're good.  Save ID in both arrays while comparing them, then clear it (so that a shared subarray can be compared again
+	// via another path).
+	bool result = true;
 	++arrayNestLevel;
 	((Array *) pArray1)->id = ((Array *) pArray2)->id = arrayID;
-	Datum **ppArrayEl1 = pArray1->elements;
-	Datum **ppArrayEl2 = pArray2->elements;
+	Datum *pArrayEl1 = pArray1->elements;
+	Datum *pArrayEl2 = pArray2->elements;
 	do {
-		if(!deq(*ppArrayEl1++, *ppArrayEl2++, aflags & AOpIgnore)) {
-			--arrayNestLevel;
-			return false;
+		if(!deq(pArrayEl1++, pArrayEl2++, aflags & AOpIgnore)) {
+			result = false;
+			break;
 			}
 		} while(--size > 0);
 
+	((Array *) pArray1)->id = ((Array *) pArray2)->id = 0;
 	--arrayNestLevel;
-	return true;
+	return result;
 	}
 
 // Concatenate *pArray1 and *pArray2 into new array and return it (or graft *pArray2 onto *pArray1 if AOpInPlace flag is set and
@@ -716,20 +1030,21 @@ Array *acat(Array *pArray1, const Array *pArray2, ushort aflags) {
 	// Make copy of first array if not concatenating in place.
 	if(aflags & AOpInPlace)
 		pArrayTarg = pArray1;
-	else if((pArrayTarg = aclone(pArray1)) == NULL)
+	else if((pArrayTarg = ashare(pArray1)) == NULL)
 		return NULL;
 
-	// Append elements from second array, if any.
+	// Append elements from second array, if any.  Array values are shared unless the first array (which may be reached from
+	// the second) is being modified in place.
 	if((used2 = pArray2->used) > 0) {
-		Datum **ppSrcEl, **ppDestEl;
+		Datum *pSrcEl, *pDestEl;
 		ArraySize used0 = pArrayTarg->used;
 
-		if(need(pArrayTarg, used2, -1, AOpFill) != 0)
+		if(aunshare(pArrayTarg) != 0 || need(pArrayTarg, used2, -1, AOpFill) != 0)
 			return NULL;
-		ppDestEl = pArrayTarg->elements + used0;
-		ppSrcEl = pArray2->elements;
+		pDestEl = pArrayTarg->elements + used0;
+		pSrcEl = pArray2->elements;
 		do {
-			if(dcpy(*ppDestEl++, *ppSrcEl++) != 0)
+			if(((aflags & AOpInPlace) ? dcpy(pDestEl++, pSrcEl++) : elcpy(pDestEl++, pSrcEl++)) != 0)
 				return NULL;
 			} while(--used2 > 0);
 		}
@@ -737,108 +1052,392 @@ Array *acat(Array *pArray1, const Array *pArray2, ushort aflags) {
 	return pArrayTarg;
 	}
 
+// Add array element at given index with given hash to a hash index.
+static void indexAdd(ArrayIndex *pIndex, ArraySize index, size_t hash) {
+	IndexSlot *pSlot;
+	size_t i = hash & pIndex->mask;
+
+	while((pSlot = pIndex->slots + i)->index != 0)
+		i = (i + 1) & pIndex->mask;
+	pSlot->hash = hash;
+	pSlot->index = index + 1;
+	}
+
+// Return true if a hash index contains an element equal to given datum with given hash, otherwise false.
+static bool indexFind(const ArrayIndex *pIndex, const Datum *pVal, size_t hash) {
+	const IndexSlot *pSlot;
+	size_t i = hash & pIndex->mask;
+
+	while((pSlot = pIndex->slots + i)->index != 0) {
+		if(pSlot->hash == hash && deq(pIndex->pArray->elements + (pSlot->index - 1), pVal, pIndex->aflags))
+			return true;
+		i = (i + 1) & pIndex->mask;
+		}
+	return false;
+	}
+
+// Initialize a hash index for given array with room for "count" elements and add the first "used" elements of the array to it.
+// Return status code.
+static int indexInit(ArrayIndex *pIndex, const Array *pArray, ArraySize count, ArraySize used, ushort aflags) {
+	size_t size = ArrayChunkSize;
+	ArraySize index;
+
+	while(size < (size_t) count * 2)			// Keep load factor at or below one half.
+		size <<= 1;
+	if((pIndex->slots = (IndexSlot *) calloc(size, sizeof(IndexSlot))) == NULL) {
+		cxlExcep.flags |= ExcepMem;
+		return emsgsys(-1);
+		}
+	pIndex->pArray = pArray;
+	pIndex->mask = size - 1;
+	pIndex->aflags = aflags & AOpIgnore;
+	for(index = 0; index < used; ++index)
+		indexAdd(pIndex, index, dhash(pArray->elements + index, pIndex->aflags));
+	return 0;
+	}
+
 // Set intersection: return new array (or pArray1 if AOpInPlace flag set) of unique elements common to *pArray1 and *pArray2, or
 // if AOpNonMatching flag set, unique elements from *pArray1 that do not occur in *pArray2.  If AOpIgnore flag set, ignore case
-// in string comparisons.
+// in string comparisons.  Elements are found in hash indexes of the second array and the result, so the operation takes
+// expected linear time.
 Array *amatch(Array *pArray1, const Array *pArray2, ushort aflags) {
-	Array *pArray;
-	Datum **ppArrayEl0, **ppArrayEl, **ppArrayElEnd;
+	Array *pArray, *pArrayCopy = NULL;
+	Datum *pArrayEl0, *pArrayEl, *pArrayElEnd;
+	ArrayIndex index1, index2;
+	size_t hash;
 	bool match = (aflags & AOpNonMatching) == 0;
 
+	index1.slots = index2.slots = NULL;
 	if(aflags & AOpInPlace) {
-		if((pArray = pArray1)->used > 0) {
+		if((pArray = pArray1)->used == 0)
+			return pArray;
 
-			// Step through elements in first array.
-			ppArrayElEnd = (ppArrayEl0 = ppArrayEl = pArray->elements) + pArray->used;
-			do {
-				if((scan(pArray2, pArray2->used, *ppArrayEl,	// Failed match or non-match with second array?
-				 aflags & AOpIgnore) >= 0) != match)
-					goto Delete;				// Yes, delete element.
-				if(scan(pArray, ppArrayEl0 - pArray->elements,	// No, duplicate?
-				 *ppArrayEl, aflags & AOpIgnore) >= 0)
-Delete:
-					dfree(*ppArrayEl);			// Yes, delete element.
-				else if(ppArrayEl == ppArrayEl0)
-					++ppArrayEl0;				// No, skip over it...
-				else
-					*ppArrayEl0++ = *ppArrayEl;		// or shift it left.
-				} while(++ppArrayEl < ppArrayElEnd);
-
-			pArray->used = ppArrayEl0 - pArray->elements;		// Update "used" length.
-			}
-		}
-	else {
-		if((pArray = create(0, NULL, 0)) == NULL)
+		// If both arrays are the same, compare elements to a copy of the original (which is shared until unshared below).
+		if(pArray2 == pArray1 && (pArray2 = pArrayCopy = ashare(pArray1)) == NULL)
 			return NULL;
-		if(pArray1->used > 0 && (pArray2->used > 0 || (aflags & AOpNonMatching))) {
+		if(aunshare(pArray) != 0)
+			goto ErrRetn;
+		}
+	else if((pArray = create(0, NULL, 0)) == NULL)
+		return NULL;
+	else if(pArray1->used == 0 || (pArray2->used == 0 && match))
+		return pArray;
 
-			// Step through elements in first array.
-			ppArrayElEnd = (ppArrayEl = pArray1->elements) + pArray1->used;
-			do {
-				if((scan(pArray2, pArray2->used, *ppArrayEl, aflags & AOpIgnore) >= 0) == match)
-					if(scan(pArray, pArray->used, *ppArrayEl, aflags & AOpIgnore) < 0)
-						if(put(pArray, pArray->used, *ppArrayEl, AOpCopy) != 0)
-							return NULL;
-				} while(++ppArrayEl < ppArrayElEnd);
+	// Index second array and result (which will have no more elements than the first array).
+	if(indexInit(&index2, pArray2, pArray2->used, pArray2->used, aflags) != 0 ||
+	 indexInit(&index1, pArray, pArray1->used, 0, aflags) != 0)
+		goto ErrRetn;
+
+	// Step through elements in first array.
+	pArrayElEnd = (pArrayEl0 = pArrayEl = pArray1->elements) + pArray1->used;
+	do {
+		hash = dhash(pArrayEl, aflags & AOpIgnore);
+		if(indexFind(&index2, pArrayEl, hash) != match ||	// Failed match or non-match with second array...
+		 indexFind(&index1, pArrayEl, hash)) {			// or duplicate?
+			if(aflags & AOpInPlace)
+				dclear(pArrayEl);			// Yes, delete element if in place.
 			}
-		}
+		else if(aflags & AOpInPlace) {
+			if(pArrayEl != pArrayEl0)			// No, shift it left if in place...
+				*pArrayEl0 = *pArrayEl;
+			indexAdd(&index1, pArrayEl0++ - pArray->elements, hash);
+			}
+		else {
+			if(put(pArray, pArray->used, pArrayEl, AOpCopy) != 0)	// or copy it to result.
+				goto ErrRetn;
+			indexAdd(&index1, pArray->used - 1, hash);
+			}
+		} while(++pArrayEl < pArrayElEnd);
+	if(aflags & AOpInPlace)
+		pArray->used = pArrayEl0 - pArray->elements;		// Update "used" length.
 
+	free((void *) index1.slots);
+	free((void *) index2.slots);
+	if(pArrayCopy != NULL)
+		afree(pArrayCopy);
 	return pArray;
+ErrRetn:
+	free((void *) index1.slots);
+	free((void *) index2.slots);
+	if(pArrayCopy != NULL)
+		afree(pArrayCopy);
+	if(!(aflags & AOpInPlace))
+		afree(pArray);
+	return NULL;
+	}
+
+// Copy elements of *pSrc that are not in hash index of *pArray to *pArray and add them to the index.  Return status code.
+static int uniqPut(Array *pArray, const Array *pSrc, ArrayIndex *pIndex, ushort aflags) {
+	ArraySize i, n = pSrc->used;
+	const Datum *pArrayEl;
+	size_t hash;
+
+	// Elements are accessed by index because *pSrc may be *pArray.
+	for(i = 0; i < n; ++i) {
+		pArrayEl = pSrc->elements + i;
+		hash = dhash(pArrayEl, aflags & AOpIgnore);
+		if(!indexFind(pIndex, pArrayEl, hash)) {
+			if(put(pArray, pArray->used, (Datum *) pArrayEl, AOpCopy) != 0)
+				return -1;
+			indexAdd(pIndex, pArray->used - 1, hash);
+			}
+		}
+	return 0;
 	}
 
 // Set union: return new array (or pArray1 if AOpInPlace flag set) of unique elements from *pArray1 and, if pArray2 not NULL,
-// *pArray2.  If AOpIgnore flag set, ignore case in string comparisons.
+// *pArray2.  If AOpIgnore flag set, ignore case in string comparisons.  Elements are found in a hash index of the result, so
+// the operation takes expected linear time.
 Array *auniq(Array *pArray1, const Array *pArray2, ushort aflags) {
 	Array *pArray;
-	Datum **ppArrayEl0, **ppArrayEl, **ppArrayElEnd;
+	ArrayIndex index;
 
 	if(aflags & AOpInPlace) {
-		if((pArray = pArray1)->used > 0) {
+		if((pArray = pArray1)->used > 0 && aunshare(pArray) != 0)
+			return NULL;
+		}
+	else if((pArray = create(0, NULL, 0)) == NULL)
+		return NULL;
+	if(indexInit(&index, pArray, pArray1->used + (pArray2 == NULL ? 0 : pArray2->used), 0, aflags) != 0)
+		goto ErrRetn;
 
-			// Step through elements in first array.
-			ppArrayElEnd = (ppArrayEl0 = ppArrayEl = pArray->elements) + pArray->used;
+	if(!(aflags & AOpInPlace)) {
+		if(uniqPut(pArray, pArray1, &index, aflags) != 0)
+			goto ErrRetn;
+		}
+	else if(pArray->used > 0) {
+		Datum *pArrayEl0, *pArrayEl, *pArrayElEnd;
+		size_t hash;
+
+		// Step through elements in first array, deleting duplicates and shifting the others left.
+		pArrayElEnd = (pArrayEl0 = pArrayEl = pArray->elements) + pArray->used;
+		do {
+			hash = dhash(pArrayEl, aflags & AOpIgnore);
+			if(indexFind(&index, pArrayEl, hash))		// Duplicate?
+				dclear(pArrayEl);			// Yes, delete element.
+			else {
+				if(pArrayEl != pArrayEl0)		// No, shift it left.
+					*pArrayEl0 = *pArrayEl;
+				indexAdd(&index, pArrayEl0++ - pArray->elements, hash);
+				}
+			} while(++pArrayEl < pArrayElEnd);
+		pArray->used = pArrayEl0 - pArray->elements;		// Update "used" length.
+		}
+	if(pArray2 != NULL && uniqPut(pArray, pArray2, &index, aflags) != 0)
+		goto ErrRetn;
+
+	free((void *) index.slots);
+	return pArray;
+ErrRetn:
+	free((void *) index.slots);
+	if(!(aflags & AOpInPlace))
+		afree(pArray);
+	return NULL;
+	}
+
+// Compare two array elements per sort control object and return result.
+static int elcmp(const SortCtrl *pCtrl, const Datum *pDatum1, const Datum *pDatum2) {
+
+	return pCtrl->cmp != NULL ? pCtrl->cmp(pDatum1, pDatum2) : dcmp(pDatum1, pDatum2, pCtrl->dflags);
+	}
+
+// Sort a short run of elements in place by insertion (which is stable).
+static void insertSort(const SortCtrl *pCtrl, Datum *pArrayEl, ArraySize len) {
+	Datum datum, *pArrayEl1, *pArrayEl2;
+	Datum *pArrayElEnd = pArrayEl + len;
+
+	for(pArrayEl1 = pArrayEl + 1; pArrayEl1 < pArrayElEnd; ++pArrayEl1)
+		if(elcmp(pCtrl, pArrayEl1 - 1, pArrayEl1) > 0) {
+			datum = *pArrayEl1;
+			pArrayEl2 = pArrayEl1;
 			do {
-				if(scan(pArray, ppArrayEl0 - pArray->elements,
-				 *ppArrayEl, aflags & AOpIgnore) >= 0)		// Duplicate?
-					dfree(*ppArrayEl);			// Yes, delete element.
-				else if(ppArrayEl == ppArrayEl0)
-					++ppArrayEl0;				// No, skip over it...
-				else
-					*ppArrayEl0++ = *ppArrayEl;		// or shift it left.
-				} while(++ppArrayEl < ppArrayElEnd);
-
-			pArray->used = ppArrayEl0 - pArray->elements;		// Update "used" length.
+				*pArrayEl2 = pArrayEl2[-1];
+				} while(--pArrayEl2 > pArrayEl && elcmp(pCtrl, pArrayEl2 - 1, &datum) > 0);
+			*pArrayEl2 = datum;
+			}
+	}
+
+// Merge two sorted runs of elements into pDest.  Elements of the first run are taken first when they compare equal to elements of
+// the second, so that the merge is stable.  If the runs are already in order, they are simply copied.
+static void merge(const SortCtrl *pCtrl, const Datum *pRun1, ArraySize len1, const Datum *pRun2, ArraySize len2,
+ Datum *pDest) {
+	const Datum *pRunEnd1 = pRun1 + len1;
+	const Datum *pRunEnd2 = pRun2 + len2;
+
+	if(len1 > 0 && len2 > 0 && elcmp(pCtrl, pRunEnd1 - 1, pRun2) > 0)
+		while(pRun1 < pRunEnd1 && pRun2 < pRunEnd2)
+			*pDest++ = elcmp(pCtrl, pRun2, pRun1) < 0 ? *pRun2++ : *pRun1++;
+	memcpy((void *) pDest, (void *) pRun1, (pRunEnd1 - pRun1) * sizeof(Datum));
+	memcpy((void *) (pDest + (pRunEnd1 - pRun1)), (void *) pRun2, (pRunEnd2 - pRun2) * sizeof(Datum));
+	}
+
+// Return the number of elements that are taken from the first of two sorted runs when the first "count" elements of their
+// (stable) merge are produced.  This is found by binary search, so that a merge can be divided among threads.
+static ArraySize mergeSplit(const SortCtrl *pCtrl, const Datum *pRun1, ArraySize len1, const Datum *pRun2, ArraySize len2,
+ ArraySize count) {
+	ArraySize i;
+	ArraySize lo = count > len2 ? count - len2 : 0;
+	ArraySize hi = count < len1 ? count : len1;
+
+	// Find smallest i for which element count - i - 1 of second run precedes element i of first run.
+	while(lo < hi) {
+		i = lo + (hi - lo) / 2;
+		if(elcmp(pCtrl, pRun2 + (count - i - 1), pRun1 + i) < 0)
+			hi = i;
+		else
+			lo = i + 1;
+		}
+	return lo;
+	}
+
+// Sort elements in place by merge sort, using given work area of the same length.
+static void mergeSort(const SortCtrl *pCtrl, Datum *pArrayEl, Datum *pWork, ArraySize len) {
+	ArraySize i, width, len1, len2;
+	Datum *pSrc = pArrayEl;
+	Datum *pDest = pWork;
+	Datum *pTemp;
+
+	// Sort short runs by insertion...
+	for(i = 0; i < len; i += SortRunSize)
+		insertSort(pCtrl, pArrayEl + i, len - i < SortRunSize ? len - i : SortRunSize);
+
+	// then merge them, doubling run length with each pass.
+	for(width = SortRunSize; width < len; width *= 2) {
+		for(i = 0; i < len; i += len1 + len2) {
+			len1 = len - i < width ? len - i : width;
+			len2 = len - i - len1 < width ? len - i - len1 : width;
+			merge(pCtrl, pSrc + i, len1, pSrc + i + len1, len2, pDest + i);
 			}
-		goto Array2;
+		pTemp = pSrc;
+		pSrc = pDest;
+		pDest = pTemp;
 		}
+	if(pSrc != pArrayEl)
+		memcpy((void *) pArrayEl, (void *) pSrc, len * sizeof(Datum));
+	}
+
+// Perform a sort task.  Return NULL (thread entry point).
+static void *sortTask(void *pTask0) {
+	SortTask *pTask = (SortTask *) pTask0;
+
+	if(!pTask->merge)
+		mergeSort(pTask->pCtrl, pTask->pSrc, pTask->pDest, pTask->len1);
 	else {
-		if((pArray = create(0, NULL, 0)) == NULL)
-			return NULL;
+		const Datum *pRun2 = pTask->pSrc + pTask->len1;
+		ArraySize i1 = mergeSplit(pTask->pCtrl, pTask->pSrc, pTask->len1, pRun2, pTask->len2, pTask->outBeg);
+		ArraySize i2 = mergeSplit(pTask->pCtrl, pTask->pSrc, pTask->len1, pRun2, pTask->len2, pTask->outEnd);
 
-		// Step through elements in first array.
-		ppArrayElEnd = (ppArrayEl = pArray1->elements) + pArray1->used;
-		while(ppArrayEl < ppArrayElEnd) {
-			if(scan(pArray, pArray->used, *ppArrayEl, aflags & AOpIgnore) < 0)
-				if(put(pArray, pArray->used, *ppArrayEl, AOpCopy) != 0)
-					return NULL;
-			++ppArrayEl;
+		merge(pTask->pCtrl, pTask->pSrc + i1, i2 - i1, pRun2 + (pTask->outBeg - i1),
+		 (pTask->outEnd - i2) - (pTask->outBeg - i1), pTask->pDest + pTask->outBeg);
+		}
+	return NULL;
+	}
+
+// Perform sort tasks concurrently, one per thread, using the calling thread for the first one.  If a thread cannot be created,
+// its task is performed by the calling thread instead.
+static void runTasks(SortTask *pTask, int count) {
+	SortTask *pTaskEnd = pTask + count;
+	SortTask *pTask1;
+
+	for(pTask1 = pTask + 1; pTask1 < pTaskEnd; ++pTask1)
+		pTask1->started = pthread_create(&pTask1->thread, NULL, sortTask, (void *) pTask1) == 0;
+	(void) sortTask((void *) pTask);
+	for(pTask1 = pTask + 1; pTask1 < pTaskEnd; ++pTask1)
+		if(pTask1->started)
+			(void) pthread_join(pTask1->thread, NULL);
+		else
+			(void) sortTask((void *) pTask1);
+	}
+
+// Sort elements in place by parallel merge sort, using given work area of the same length and "threads" threads (a power of 2).
+// The elements are divided into one run per thread, the runs are sorted concurrently, and then pairs of runs are merged until
+// one remains, with each merge divided among the threads.
+static void parSort(const SortCtrl *pCtrl, Datum *pArrayEl, Datum *pWork, ArraySize len, int threads) {
+	SortTask tasks[SortMaxThreads], *pTask;
+	ArraySize bounds[SortMaxThreads + 1];
+	ArraySize len1, len2;
+	Datum *pSrc = pArrayEl;
+	Datum *pDest = pWork;
+	Datum *pTemp;
+	int i, j, runs, parts;
+
+	// Sort runs.
+	for(i = 0; i <= threads; ++i)
+		bounds[i] = len / threads * i + len % threads * i / threads;
+	for(i = 0; i < threads; ++i)
+		tasks[i] = (SortTask) {pCtrl, false, pArrayEl + bounds[i], pWork + bounds[i], bounds[i + 1] - bounds[i]};
+	runTasks(tasks, threads);
+
+	// Merge pairs of runs, dividing each merge into equal parts of output.
+	for(runs = threads; runs > 1; runs /= 2) {
+		pTask = tasks;
+		parts = threads / (runs / 2);
+		for(i = 0; i < runs; i += 2) {
+			len1 = bounds[i + 1] - bounds[i];
+			len2 = bounds[i + 2] - bounds[i + 1];
+			for(j = 0; j < parts; ++j)
+				*pTask++ = (SortTask) {pCtrl, true, pSrc + bounds[i], pDest + bounds[i], len1, len2,
+				 (len1 + len2) / parts * j + (len1 + len2) % parts * j / parts,
+				 (len1 + len2) / parts * (j + 1) + (len1 + len2) % parts * (j + 1) / parts};
 			}
+		runTasks(tasks, threads);
+		for(i = 1; i <= runs / 2; ++i)
+			bounds[i] = bounds[i * 2];
+		pTemp = pSrc;
+		pSrc = pDest;
+		pDest = pTemp;
+		}
+	if(pSrc != pArrayEl)
+		memcpy((void *) pArrayEl, (void *) pSrc, len * sizeof(Datum));
+	}
+
+// Sort an array and return the result, or NULL if error.  If AOpInPlace flag is set, the array is sorted in place and pArray is
+// returned; otherwise, a new array is created that contains the sorted elements.  The sort is stable; that is, elements that
+// compare equal remain in their original order.  Elements are compared by calling "cmp" (which returns a value less than, equal
+// to, or greater than zero, like strcmp()) if it is not NULL; otherwise, by calling dcmp() with DOpIgnore flag if AOpIgnore flag
+// is set.  A large array is sorted with multiple threads, so "cmp" must be safe to call from any thread concurrently, and may not
+// fail.
+Array *asort(Array *pArray, int (*cmp)(const Datum *pDatum1, const Datum *pDatum2), ushort aflags) {
+	Array *pArrayTarg;
+	Datum *pWork;
+	SortCtrl ctrl = {cmp, aflags & AOpIgnore};
 
-Array2:
-		if(pArray2 != NULL) {
+	if(aflags & AOpInPlace)
+		pArrayTarg = pArray;
+	else if((pArrayTarg = ashare(pArray)) == NULL)
+		return NULL;
+	if(pArrayTarg->used > 1) {
+		if(aunshare(pArrayTarg) != 0)
+			goto ErrRetn;
 
-			// Step through elements in second array.
-			ppArrayElEnd = (ppArrayEl = pArray2->elements) + pArray2->used;
-			while(ppArrayEl < ppArrayElEnd) {
-				if(scan(pArray, pArray->used, *ppArrayEl, aflags & AOpIgnore) < 0)
-					if(put(pArray, pArray->used, *ppArrayEl, AOpCopy) != 0)
-						return NULL;
-				++ppArrayEl;
+		// Short array?  Sort it by insertion.
+		if(pArrayTarg->used <= SortRunSize)
+			insertSort(&ctrl, pArrayTarg->elements, pArrayTarg->used);
+		else {
+			long threads = 1;
+			long cpus;
+
+			// Get work area and determine number of threads to use.
+			if((pWork = (Datum *) malloc(pArrayTarg->used * sizeof(Datum))) == NULL) {
+				cxlExcep.flags |= ExcepMem;
+				(void) emsgsys(-1);
+				goto ErrRetn;
 				}
+			if(pArrayTarg->used >= SortParMin && (cpus = sysconf(_SC_NPROCESSORS_ONLN)) > 1)
+				while(threads * 2 <= cpus && threads < SortMaxThreads)
+					threads *= 2;
+			if(threads == 1)
+				mergeSort(&ctrl, pArrayTarg->elements, pWork, pArrayTarg->used);
+			else
+				parSort(&ctrl, pArrayTarg->elements, pWork, pArrayTarg->used, threads);
+			free((void *) pWork);
 			}
 		}
-
-	return pArray;
+	return pArrayTarg;
+ErrRetn:
+	if(pArrayTarg != pArray)
+		afree(pArrayTarg);
+	return NULL;
 	}
 
 // Write an array in string form to a fabrication object per cflags, via calls to dputd(), and return status code.  If ACvtBrkts
@@ -846,10 +1445,17 @@ Array2:
 // separated by "delim" delimiters if delim not NULL, otherwise commas if ACvtDelim flag set, otherwise a null string.  Array
 // elements are converted via calls to dputd(), except that nil elements are skipped if CvtSkipNil flag is set.  In all cases,
 // if the array includes itself, recursion stops, "[...]" (or "..." if no brackets) is written for the nested occurrence, and 1
-// is returned instead of zero.
+// is returned instead of zero.  If prepending, the array is written to a temporary fabrication object first and the result is
+// prepended.
 int aput(const Array *pArray, DFab *pFab, const char *delim, ushort cflags) {
 	int rtnCode = 0;
 
+	if((pFab->flags & FabModeMask) == FabPrepend) {
+		DFab fab, *pTempFab;
+
+		return (pTempFab = bopentemp(&fab)) == NULL ? -1 : bputfab(pTempFab, pFab, aput(pArray, pTempFab, delim, cflags));
+		}
+
 	// Generate new array ID if at top-level.
 	if(arrayNestLevel == 0)
 		genArrayID();
@@ -868,7 +1474,7 @@ int aput(const Array *pArray, DFab *pFab, const char *delim, ushort cflags) {
 	else {
 		int r;
 		Datum *pDatum;
-		Datum **ppArrayEl = pArray->elements;
+		Datum *pArrayEl = pArray->elements;
 		ArraySize n = pArray->used;
 		bool first = true;
 		const char *realDelim = delim != NULL ? delim : cflags & ACvtDelim ? ", " : NULL;
@@ -878,7 +1484,7 @@ int aput(const Array *pArray, DFab *pFab, const char *delim, ushort cflags) {
 			goto ErrRetn;
 
 		while(n-- > 0) {
-			pDatum = *ppArrayEl++;
+			pDatum = pArrayEl++;
 
 			// Skip nil value if requested.
 			if(pDatum->type == dat_nil && (cflags & ACvtSkipNil))
@@ -895,6 +1501,10 @@ int aput(const Array *pArray, DFab *pFab, const char *delim, ushort cflags) {
 			}
 		if((cflags & (ACvtBrkts | ACvtNoBrkts)) == ACvtBrkts && bputc(']', pFab) != 0)
 			goto ErrRetn;
+
+		// Clear mark so that an array reached again by a different path (a shared subarray) is not mistaken for one
+		// that includes itself.
+		((Array *) pArray)->id = 0;
 		}
 
 	--arrayNestLevel;
@@ -912,7 +1522,7 @@ int ajoin(Datum *pDatum, const Array *pArray, const char *delim, ushort cflags)
 	if(pArray->used == 0)
 		dsetnull(pDatum);
 	else if(pArray->used == 1)
-		rtnCode = dtos(pDatum, pArray->elements[0], delim, cflags);
+		rtnCode = dtos(pDatum, pArray->elements, delim, cflags);
 	else {
 		DFab fab;
 
@@ -21,16 +21,81 @@
 #define ChunkSize0	64			// Starting size of fabrication chunks/pieces.
 #define ChunkSize4	512			// Size at which to begin quadrupling until hit maximum.
 #define ChunkSizeMax	32768			// Maximum size (32K).
+#define DatPoolMax	8192			// Maximum number of released Datum objects to keep for reuse.
+#define GarbStackSize0	64			// Starting size of garbage collection stack.
+#define SymTabSize0	64			// Starting number of slots in symbol table (must be a power of 2).
+
+#define miniStr(pDatum)	((char *) (pDatum) + DMiniOffset)
+						// Mini string buffer in a Datum object.
+
+// Shared string buffer: holds a reference-counted string (type dat_sharedStr) which may be referenced by multiple Datum objects.
+// The longStr.ptr member of each Datum object points to the string that immediately follows the header.
+typedef struct {
+	size_t refCount;			// Number of Datum objects referencing string.
+	char str[];				// String value.
+	} StrBuf;
+
+#define strBuf(strPtr)	((StrBuf *) ((strPtr) - offsetof(StrBuf, str)))
+#define StrBufSym	((size_t) 1 << (sizeof(size_t) * CHAR_BIT - 1))
+						// Reference count flag indicating that string is a symbol.
+
+// Symbol buffer: holds a string that has been interned in a symbol table.  Its last two members have the same layout as a shared
+// string buffer, so a symbol is a shared string whose reference count has the StrBufSym flag set.  The symbol table holds one
+// reference, so the string is never modified in place or moved by dunshare() or plainStr(); rather, it is copied.
+typedef struct SymBuf {
+	struct SymBuf *next;			// Link to next symbol in hash chain.
+	size_t tabID;				// ID of symbol table that string was interned in.
+	size_t hash;				// Hash of string.
+	size_t len;				// Length of string.
+	size_t refCount;			// Number of Datum objects (and symbol table) referencing string, plus StrBufSym flag.
+	char str[];				// String value.
+	} SymBuf;
+
+#define symBuf(strPtr)	((SymBuf *) ((strPtr) - offsetof(SymBuf, str)))
+
+// Pooled Datum object: a released Datum object's memory is used to link it into a garbage collection context's pool.
+typedef struct PoolDatum {
+	struct PoolDatum *next;			// Link to next item in pool.
+	} PoolDatum;
+
+// Thread-local variables.
+static __thread DGarbCtx garbCtx0;		// Default garbage collection context for each thread.
+static __thread DGarbCtx *pGarbCtx = NULL;	// Current garbage collection context, or NULL if not set yet.
+static __thread DSymTab symTab0;		// Default symbol table for each thread.
+static __thread DFab tempFab;			// Reusable temporary fabrication object for prepending (see bopentemp()).
+static __thread Datum tempDatum;		// Datum object of tempFab (never set).
+static __thread bool tempFabOpen = false;	// tempFab is in use.
 
 // Global variables.
-Datum *datGarbHead = NULL;			// Head of list of temporary Datum objects, for "garbage collection".
+static size_t symTabCount = 0;			// Number of symbol table IDs assigned.
 
-// Initialize a Datum object to nil.  It is assumed that any allocated memory has already been freed or datum is a
-// local variable.
+// Initialize a Datum object to nil and clear its flags.  It is assumed that any allocated memory has already been freed or datum
+// is a local variable or was allocated by the caller.
 void dinit(Datum *pDatum) {
 
 	pDatum->type = dat_nil;
-	pDatum->str = NULL;
+	pDatum->flags = 0;
+	}
+
+// Release a reference to a shared string (or symbol) and free its buffer if no references remain.
+static void sharedFree(char *str) {
+	StrBuf *pStrBuf = strBuf(str);
+	size_t refCount = __atomic_sub_fetch(&pStrBuf->refCount, 1, __ATOMIC_ACQ_REL);
+
+	if(refCount == 0)
+		free((void *) pStrBuf);
+	else if(refCount == StrBufSym)
+		free((void *) symBuf(str));
+	}
+
+// Free a rope and its pieces.
+static void ropeFree(DRope *pRope) {
+	DMem *pPiece = pRope->pieces;
+	DMem *pPieceEnd = pPiece + pRope->count;
+
+	for(; pPiece < pPieceEnd; ++pPiece)
+		free(pPiece->ptr);
+	free((void *) pRope);
 	}
 
 // Clear a Datum object and set it to nil.
@@ -39,62 +104,179 @@ void dclear(Datum *pDatum) {
 	// Free any string, byte string, or array storage.
 	switch(pDatum->type) {
 		case dat_longStr:
-			free((void *) pDatum->str);
+			free((void *) pDatum->u.longStr.ptr);
+			break;
+		case dat_sharedStr:
+			sharedFree(pDatum->u.longStr.ptr);
 			break;
 		case dat_byteStr:
 			if(pDatum->u.mem.ptr != NULL)
 				free((void *) pDatum->u.mem.ptr);
 			break;
+		case dat_rope:
+			ropeFree(pDatum->u.pRope);
+			break;
 		case dat_array:
 			afree(pDatum->u.pArray);
 		}
-	dinit(pDatum);
+	dsetnilval(pDatum);
 	}
 
-// Free memory for given Datum object; that is, clear (free) its contents and free the object.  It assumed that either the
-// object was permanent and not in the garbage collection list, or the caller is removing it from the list; for example, when
-// called from dgarbpop().
-void dfree(Datum *pDatum) {
+// Return the calling thread's current garbage collection context.
+DGarbCtx *dgarbctx(void) {
 
-	dclear(pDatum);
-	free((void *) pDatum);
+	return (pGarbCtx != NULL) ? pGarbCtx : (pGarbCtx = &garbCtx0);
 	}
 
-// Change a datum with allocated data to the corresponding reference type, if possible, and return status code.
-int drelease(Datum *pDatum) {
+// Make given garbage collection context (or the thread's default context if pCtx is NULL) the current one for the calling
+// thread and return the previous one.
+DGarbCtx *dgarbswitch(DGarbCtx *pCtx) {
+	DGarbCtx *pOldCtx = dgarbctx();
 
-	switch(pDatum->type) {
-		case dat_miniStr:
-			return emsgf(-1, "drelease(): String \"%s\" was not allocated", pDatum->str);
-		case dat_longStr:
-			pDatum->type = dat_longStrRef;
-			break;
-		case dat_byteStr:
-			pDatum->type = dat_byteStrRef;
-			break;
-		case dat_array:
-			pDatum->type = dat_arrayRef;
-			break;
+	pGarbCtx = (pCtx != NULL) ? pCtx : &garbCtx0;
+	return pOldCtx;
+	}
+
+// Initialize a garbage collection context as empty.
+void dgarbinit(DGarbCtx *pCtx) {
+
+	*pCtx = (DGarbCtx) {NULL, 0, 0, 0, NULL, 0};
+	}
+
+// Return the Datum object at the top of the calling thread's current garbage collection stack, or NULL if the stack is empty.
+Datum *dgarbhead(void) {
+	DGarbCtx *pCtx = dgarbctx();
+
+	return (pCtx->count == 0) ? NULL : pCtx->stack[pCtx->count - 1];
+	}
+
+// Push a Datum object onto a context's garbage collection stack, growing the stack if needed.  Return status code.
+static int garbPush(DGarbCtx *pCtx, Datum *pDatum) {
+
+	if(pCtx->count == pCtx->size) {
+		size_t size = (pCtx->size == 0) ? GarbStackSize0 : pCtx->size * 2;
+		Datum **stack;
+
+		if((stack = (Datum **) realloc((void *) pCtx->stack, size * sizeof(Datum *))) == NULL) {
+			cxlExcep.flags |= ExcepMem;
+			return emsgsys(-1);
+			}
+		pCtx->stack = stack;
+		pCtx->size = size;
 		}
+	pCtx->stack[pCtx->count++] = pDatum;
 	return 0;
 	}
 
-// Pop datGarbHead to given pointer, releasing heap space and laughing all the way.
+// Return an unused Datum object to a context's pool for reuse, or free it if the pool is full.
+static void poolPut(DGarbCtx *pCtx, Datum *pDatum) {
+
+	if(pCtx->poolCount < DatPoolMax) {
+		PoolDatum *pPoolDatum = (PoolDatum *) pDatum;
+
+		pPoolDatum->next = (PoolDatum *) pCtx->pool;
+		pCtx->pool = (void *) pPoolDatum;
+		++pCtx->poolCount;
+		}
+	else
+		free((void *) pDatum);
+	}
+
+// Remove the Datum object at the top of a context's garbage collection stack and release it if it is tracked or was freed
+// while on the stack; otherwise, leave it intact for its owner.
+static void garbPop(DGarbCtx *pCtx) {
+	Datum *pDatum = pCtx->stack[--pCtx->count];
+
+	if(pDatum->flags & (DFTracked | DFDead)) {
+		if(!(pDatum->flags & DFDead))
+			dclear(pDatum);
+		poolPut(pCtx, pDatum);
+		}
+	else
+		pDatum->flags &= DFElement;
+	}
+
+// Return true if given Datum object is at the top of a context's garbage collection stack and no scope is using its position,
+// otherwise false.
+static bool garbIsTop(DGarbCtx *pCtx, const Datum *pDatum) {
+
+	return pCtx->count > pCtx->floor && pCtx->stack[pCtx->count - 1] == pDatum;
+	}
+
+// Free memory for given Datum object; that is, clear (free) its contents and free the object.  If the object is on the garbage
+// collection stack, it is removed if it is at the top and no scope is using its position; otherwise, it is marked "dead" and
+// its memory is released when the stack is popped.
+void dfree(Datum *pDatum) {
+
+	dclear(pDatum);
+	if(!(pDatum->flags & DFListed))
+		free((void *) pDatum);
+	else {
+		DGarbCtx *pCtx = dgarbctx();
+
+		if(garbIsTop(pCtx, pDatum)) {
+			--pCtx->count;
+			poolPut(pCtx, pDatum);
+			}
+		else
+			pDatum->flags = DFListed | DFDead;
+		}
+	}
+
+// Pop garbage collection stack to given pointer (or to the bottom if not found), releasing heap space and laughing all the
+// way.
 void dgarbpop(const Datum *pDatum) {
-	Datum *pDatum1;
+	DGarbCtx *pCtx = dgarbctx();
 
-	while(datGarbHead != pDatum) {
-		pDatum1 = datGarbHead;
-		datGarbHead = datGarbHead->next;
-		dfree(pDatum1);
+	while(pCtx->count > 0 && pCtx->stack[pCtx->count - 1] != pDatum)
+		garbPop(pCtx);
+	}
+
+// Release all datums on a garbage collection context's stack (or the current context's stack if pCtx is NULL), free its pool
+// of unused Datum objects, and reinitialize it.  If it is the thread's default context, also release the work buffer kept for
+// prepending conversions (see bopentemp()).  A thread should call this function for its default context before it exits.
+void dgarbfree(DGarbCtx *pCtx) {
+	PoolDatum *pPoolDatum;
+
+	if(pCtx == NULL)
+		pCtx = dgarbctx();
+	while(pCtx->count > 0)
+		garbPop(pCtx);
+	if(pCtx == &garbCtx0 && !tempFabOpen)
+		dreset(&tempFab);		// Release thread's temporary fabrication buffer as well.
+	free((void *) pCtx->stack);
+	while((pPoolDatum = (PoolDatum *) pCtx->pool) != NULL) {
+		pCtx->pool = (void *) pPoolDatum->next;
+		free((void *) pPoolDatum);
 		}
+	dgarbinit(pCtx);
+	}
+
+// Open a scope on the garbage collection stack; that is, mark the current stack position so that it can be restored by
+// dscopeclose().
+void dscopeopen(DScope *pScope) {
+	DGarbCtx *pCtx = dgarbctx();
+
+	pScope->depth = pCtx->count;
+	pScope->floor = pCtx->floor;
+	pCtx->floor = pCtx->count;
+	}
+
+// Close a scope on the garbage collection stack, releasing all datums that were tracked after the scope was opened (in one
+// step) and restoring the enclosing scope.
+void dscopeclose(DScope *pScope) {
+	DGarbCtx *pCtx = dgarbctx();
+
+	while(pCtx->count > pScope->depth)
+		garbPop(pCtx);
+	pCtx->floor = pScope->floor;
 	}
 
 // Set a Datum object to a null "mini" string.
 void dsetnull(Datum *pDatum) {
 
 	dclear(pDatum);
-	*(pDatum->str = pDatum->u.miniStr) = '\0';
+	*miniStr(pDatum) = '\0';
 	pDatum->type = dat_miniStr;
 	}
 
@@ -148,12 +330,15 @@ void dadoptmem(void *memPtr, size_t size, Datum *pDatum) {
 	setMemRef(memPtr, size, pDatum, dat_byteStr);
 	}
 
-// Set an array in a Datum object (clone array), given array pointer.  Return status code.
+// Set an array in a Datum object, given array pointer.  The array's elements are shared with the copy (see ashare()) unless the
+// Datum object is an array element, in which case the array is cloned instead; otherwise, the element could end up in the array
+// it refers to, directly or via a nested array.  Array elements are identified by the DFElement flag, which is set only by the
+// array routines (dinit() clears it).  Return status code.
 int dsetarray(const Array *pArray, Datum *pDatum) {
 	Array *pArray1;
 
 	dclear(pDatum);
-	if((pArray1 = aclone(pArray)) == NULL)
+	if((pArray1 = (pDatum->flags & DFElement) ? aclone(pArray) : ashare(pArray)) == NULL)
 		return -1;
 	pDatum->type = dat_array;
 	pDatum->u.pArray = pArray1;
@@ -217,7 +402,7 @@ void dsetreal(double d, Datum *pDatum) {
 // Return status code.
 static int salloc(char **pStr, size_t len, char *miniBuf) {
 
-	if(miniBuf != NULL && len <= sizeof(DMem))
+	if(miniBuf != NULL && len <= DMiniSize)
 		*pStr = miniBuf;
 	else if((*pStr = (char *) malloc(len)) == NULL) {
 		cxlExcep.flags |= ExcepMem;
@@ -226,102 +411,352 @@ static int salloc(char **pStr, size_t len, char *miniBuf) {
 	return 0;
 	}
 
-// Allocate a string value of given size in a Datum object.  Return status code.
-int dsalloc(Datum *pDatum, size_t len) {
+// Get space for a shared string with a reference count of one and set *pStr to it.  If a mini string will work, use caller's
+// mini buffer 'miniBuf' (if not NULL).  Return status code.
+static int shalloc(char **pStr, size_t len, char *miniBuf) {
 
-	dsetnull(pDatum);
-	if(len > sizeof(DMem)) {
-		if(salloc(&pDatum->u.longStr, len, NULL) != 0)
+	if(miniBuf != NULL && len <= DMiniSize)
+		*pStr = miniBuf;
+	else {
+		StrBuf *pStrBuf;
+
+		if(salloc(pStr, sizeof(StrBuf) + len, NULL) != 0)
 			return -1;
-		*(pDatum->str = pDatum->u.longStr) = '\0';
-		pDatum->type = dat_longStr;
+		pStrBuf = (StrBuf *) *pStr;
+		pStrBuf->refCount = 1;
+		*pStr = pStrBuf->str;
 		}
 	return 0;
 	}
 
-// Set a string in a Datum object of given type.
-static void setStrRef(char *str, Datum *pDatum, DatumType type) {
+// Set a string of given length (or DStrLenUnk if unknown) in a Datum object of given type.
+static void setStrRef(char *str, size_t len, Datum *pDatum, DatumType type) {
 
 	dclear(pDatum);
-	pDatum->str = pDatum->u.longStr = str;
+	pDatum->u.longStr.ptr = str;
+	pDatum->u.longStr.len = len;
 	pDatum->type = type;
 	}
 
+// Return length of string in a Datum object, which is assumed to be a string type.  If the length of a long string is unknown,
+// it is determined and cached in the object.
+size_t dstrlen(const Datum *pDatum) {
+
+	if(pDatum->type == dat_miniStr)
+		return strlen(miniStr(pDatum));
+	if(pDatum->u.longStr.len == DStrLenUnk)
+		((Datum *) pDatum)->u.longStr.len = strlen(pDatum->u.longStr.ptr);
+	return pDatum->u.longStr.len;
+	}
+
+// Convert a shared string in a Datum object to a string that is allocated by malloc() and owned solely by the object (type
+// dat_longStr).  If the object holds the only reference, the string is moved to the beginning of its buffer; otherwise, it is
+// copied.  Return status code.
+static int plainStr(Datum *pDatum) {
+	StrBuf *pStrBuf = strBuf(pDatum->u.longStr.ptr);
+	size_t len = dstrlen(pDatum);
+	char *str;
+
+	if(__atomic_load_n(&pStrBuf->refCount, __ATOMIC_ACQUIRE) == 1) {
+		str = (char *) memmove((void *) pStrBuf, (void *) pStrBuf->str, len + 1);
+		dsetnilval(pDatum);
+		}
+	else {
+		if(salloc(&str, len + 1, NULL) != 0)
+			return -1;
+		memcpy((void *) str, (void *) pStrBuf->str, len + 1);
+		}
+	setStrRef(str, len, pDatum, dat_longStr);
+	return 0;
+	}
+
+// Prepare the string in a Datum object to be modified in place; that is, copy a shared string if any other references to it
+// exist so that it is not shared with any other Datum object, and forget the cached length of a long string.  Return status
+// code.
+int dunshare(Datum *pDatum) {
+
+	if(pDatum->type == dat_sharedStr &&
+	 __atomic_load_n(&strBuf(pDatum->u.longStr.ptr)->refCount, __ATOMIC_ACQUIRE) > 1) {
+		char *str;
+		size_t len = dstrlen(pDatum) + 1;
+
+		if(shalloc(&str, len, NULL) != 0)
+			return -1;
+		memcpy((void *) str, (void *) pDatum->u.longStr.ptr, len);
+		setStrRef(str, DStrLenUnk, pDatum, dat_sharedStr);
+		}
+	else if(pDatum->type & (dat_longStr | dat_longStrRef | dat_sharedStr))
+		pDatum->u.longStr.len = DStrLenUnk;
+	return 0;
+	}
+
+// Change a datum with allocated data to the corresponding reference type, if possible, and return status code.  A shared
+// string is first converted to a string allocated by malloc() so that it can be passed to free() by the caller.
+int drelease(Datum *pDatum) {
+
+	switch(pDatum->type) {
+		case dat_miniStr:
+			return emsgf(-1, "drelease(): String \"%s\" was not allocated", miniStr(pDatum));
+		case dat_sharedStr:
+			if(plainStr(pDatum) != 0)
+				return -1;
+			// Fall through.
+		case dat_longStr:
+			pDatum->type = dat_longStrRef;
+			break;
+		case dat_byteStr:
+			pDatum->type = dat_byteStrRef;
+			break;
+		case dat_array:
+			pDatum->type = dat_arrayRef;
+			break;
+		}
+	return 0;
+	}
+
+// Allocate a string value of given size in a Datum object.  Return status code.
+int dsalloc(Datum *pDatum, size_t len) {
+
+	dsetnull(pDatum);
+	if(len > DMiniSize) {
+		char *str;
+
+		if(shalloc(&str, len, NULL) != 0)
+			return -1;
+		*str = '\0';
+		setStrRef(str, DStrLenUnk, pDatum, dat_sharedStr);
+		}
+	return 0;
+	}
+
 // Store a pointer to a string currently allocated in memory into a Datum object; that is, "adopt" the string and free it when
 // the Datum object is cleared.
 void dadoptstr(char *str, Datum *pDatum) {
 
-	setStrRef(str, pDatum, dat_longStr);
+	setStrRef(str, DStrLenUnk, pDatum, dat_longStr);
 	}
 
 // Set a string reference in a Datum object.
 void dsetstrref(char *str, Datum *pDatum) {
 
-	setStrRef(str, pDatum, dat_longStrRef);
+	setStrRef(str, DStrLenUnk, pDatum, dat_longStrRef);
 	}
 
-// Set a substring (up to "len" characters) in a Datum object.  Routine assumes that the source string may be all or part of the
-// dest object.  Return status code.
-int dsetsubstr(const char *str, size_t len, Datum *pDatum) {
+// Set a string of given length (which contains no null bytes) in a Datum object.  Routine assumes that the source string may be
+// all or part of the dest object.  Return status code.
+static int setSubstr(const char *str, size_t len, Datum *pDatum) {
 	char *str0;
 
-	if(dtypstr(pDatum) && str >= pDatum->str) {		// If string overlap possible...
-		char workBuf[sizeof(DMem)];
+	if(dtypstr(pDatum) && str >= dstr(pDatum)) {		// If string overlap possible...
+		char workBuf[DMiniSize];
 
-		if(salloc(&str0, len + 1, workBuf) != 0)	// Get space for string if not a mini...
+		if(shalloc(&str0, len + 1, workBuf) != 0)	// Get space for string if not a mini...
 			return -1;
-		stplcpy(str0, str, len + 1);			// and copy string to new buffer.
+		memcpy((void *) str0, (void *) str, len);	// and copy string to new buffer.
+		str0[len] = '\0';
 		if(str0 == workBuf) {				// If mini string...
 			dsetnull(pDatum);			// clear datum...
-			strcpy(pDatum->u.miniStr, workBuf);	// and copy string to it.
+			strcpy(miniStr(pDatum), workBuf);	// and copy string to it.
 			}
 		else
 			goto Adopt;				// Otherwise, set allocated string in pDatum.
 		}
-	else if(len < sizeof(DMem)) {				// No overlap.  If string fits in mini string...
+	else if(len < DMiniSize) {				// No overlap.  If string fits in mini string...
 		dsetnull(pDatum);				// clear datum...
-		stplcpy(pDatum->u.miniStr, str, len + 1);	// and copy string to mini buffer.
+		memcpy((void *) miniStr(pDatum), (void *) str, len);	// and copy string to mini buffer.
+		miniStr(pDatum)[len] = '\0';
 		}
 	else {							// String won't fit.
-		if(salloc(&str0, len + 1, NULL) != 0)		// Get space for string...
+		if(shalloc(&str0, len + 1, NULL) != 0)		// Get space for string...
 			return -1;
-		stplcpy(str0, str, len + 1);			// copy string to memory buffer...
+		memcpy((void *) str0, (void *) str, len);	// copy string to memory buffer...
+		str0[len] = '\0';
 Adopt:
-		dadoptstr(str0, pDatum);			// and set allocated string in datum.
+		setStrRef(str0, len, pDatum, dat_sharedStr);	// and set shared string in datum.
 		}
 
 	return 0;
 	}
 
+// Set a substring (up to "len" characters) in a Datum object.  Routine assumes that the source string may be all or part of the
+// dest object.  Return status code.
+int dsetsubstr(const char *str, size_t len, Datum *pDatum) {
+	const char *str1 = (const char *) memchr((void *) str, '\0', len);
+
+	return setSubstr(str, str1 != NULL ? (size_t) (str1 - str) : len, pDatum);
+	}
+
+// Set a substring reference (of "len" bytes, which is not null-terminated) in a Datum object, given pointer to the first byte of
+// the substring in a string or buffer that must remain valid for the life of the reference.
+void dsetsubstrref(const char *str, size_t len, Datum *pDatum) {
+
+	setMemRef((void *) str, len, pDatum, dat_substrRef);
+	}
+
 // Set a string value in a Datum object.  Return status code.
 int dsetstr(const char *str, Datum *pDatum) {
 
-	return dsetsubstr(str, strlen(str), pDatum);
+	return setSubstr(str, strlen(str), pDatum);
+	}
+
+// Initialize a symbol table as empty.  An ID is assigned when the first string is interned.
+void dsymtabinit(DSymTab *pTab) {
+
+	*pTab = (DSymTab) {NULL, 0, 0, 0};
+	}
+
+// Release the symbol table's references to its strings (or the calling thread's default table's if pTab is NULL) and reset it
+// to empty.  Symbols held by Datum objects remain valid.  A thread that interned symbols in its default table should call
+// this function with a NULL argument before it exits.
+void dsymtabfree(DSymTab *pTab) {
+
+	if(pTab == NULL)
+		pTab = &symTab0;
+	if(pTab->slots != NULL) {
+		SymBuf **ppSlot = (SymBuf **) pTab->slots;
+		SymBuf **ppSlotEnd = ppSlot + pTab->size;
+		SymBuf *pSymBuf, *pNext;
+
+		for(; ppSlot < ppSlotEnd; ++ppSlot)
+			for(pSymBuf = *ppSlot; pSymBuf != NULL; pSymBuf = pNext) {
+				pNext = pSymBuf->next;
+				sharedFree(pSymBuf->str);
+				}
+		free((void *) pTab->slots);
+		}
+	dsymtabinit(pTab);
+	}
+
+// Return hash of a string of given length.  The string is processed eight bytes at a time.
+static size_t symHash(const char *str, size_t len) {
+	uint64_t x;
+	uint64_t h = len * 0x9e3779b97f4a7c15ull;
+
+	for(; len >= 8; str += 8, len -= 8) {
+		memcpy((void *) &x, (void *) str, sizeof(x));
+		h = (h ^ x) * 0xff51afd7ed558ccdull;
+		h ^= h >> 32;
+		}
+	x = 0;
+	memcpy((void *) &x, (void *) str, len);
+	h = (h ^ x) * 0xc4ceb9fe1a85ec53ull;
+	return h ^ (h >> 29);
+	}
+
+// Double the number of slots in a symbol table and rehash its symbols.  Return status code.
+static int symGrow(DSymTab *pTab) {
+	size_t size = (pTab->size == 0) ? SymTabSize0 : pTab->size * 2;
+	SymBuf **slots, **ppSlot, **ppSlotEnd;
+	SymBuf *pSymBuf, *pNext;
+
+	if((slots = (SymBuf **) calloc(size, sizeof(SymBuf *))) == NULL) {
+		cxlExcep.flags |= ExcepMem;
+		return emsgsys(-1);
+		}
+	if(pTab->slots != NULL) {
+		ppSlotEnd = (ppSlot = (SymBuf **) pTab->slots) + pTab->size;
+		for(; ppSlot < ppSlotEnd; ++ppSlot)
+			for(pSymBuf = *ppSlot; pSymBuf != NULL; pSymBuf = pNext) {
+				pNext = pSymBuf->next;
+				pSymBuf->next = slots[pSymBuf->hash & (size - 1)];
+				slots[pSymBuf->hash & (size - 1)] = pSymBuf;
+				}
+		free((void *) pTab->slots);
+		}
+	pTab->slots = (void **) slots;
+	pTab->size = size;
+	return 0;
+	}
+
+// Set a substring (up to "len" characters) in a Datum object as a symbol; that is, intern it in given symbol table (or the
+// calling thread's default table if pTab is NULL) so that all Datum objects set to an equal string with the same table share
+// one copy of it.  Return status code.
+int dsetsubsym(const char *str, size_t len, DSymTab *pTab, Datum *pDatum) {
+	const char *str1 = (const char *) memchr((void *) str, '\0', len);
+	SymBuf **ppSlot;
+	SymBuf *pSymBuf;
+	size_t hash;
+
+	if(str1 != NULL)
+		len = str1 - str;
+	if(pTab == NULL)
+		pTab = &symTab0;
+	if(pTab->id == 0)
+		pTab->id = __atomic_add_fetch(&symTabCount, 1, __ATOMIC_RELAXED);
+
+	// Look for string in table.
+	hash = symHash(str, len);
+	if(pTab->slots != NULL)
+		for(pSymBuf = ((SymBuf **) pTab->slots)[hash & (pTab->size - 1)]; pSymBuf != NULL; pSymBuf = pSymBuf->next)
+			if(pSymBuf->hash == hash && pSymBuf->len == len && memcmp((void *) pSymBuf->str, (void *) str, len) == 0) {
+				__atomic_add_fetch(&pSymBuf->refCount, 1, __ATOMIC_RELAXED);
+				goto Found;
+				}
+
+	// Not found.  Add it, growing table first if it is full.
+	if(pTab->count == pTab->size && symGrow(pTab) != 0)
+		return -1;
+	if((pSymBuf = (SymBuf *) malloc(sizeof(SymBuf) + len + 1)) == NULL) {
+		cxlExcep.flags |= ExcepMem;
+		return emsgsys(-1);
+		}
+	pSymBuf->tabID = pTab->id;
+	pSymBuf->hash = hash;
+	pSymBuf->len = len;
+	pSymBuf->refCount = StrBufSym | 2;		// Symbol table and Datum object.
+	memcpy((void *) pSymBuf->str, (void *) str, len);
+	pSymBuf->str[len] = '\0';
+	ppSlot = (SymBuf **) pTab->slots + (hash & (pTab->size - 1));
+	pSymBuf->next = *ppSlot;
+	*ppSlot = pSymBuf;
+	++pTab->count;
+Found:
+	setStrRef(pSymBuf->str, len, pDatum, dat_sharedStr);
+	return 0;
+	}
+
+// Set a string value in a Datum object as a symbol via dsetsubsym().  Return status code.
+int dsetsym(const char *str, DSymTab *pTab, Datum *pDatum) {
+
+	return dsetsubsym(str, strlen(str), pTab, pDatum);
+	}
+
+// Return true if a Datum object holds a symbol, otherwise false.
+bool dissym(const Datum *pDatum) {
+
+	return pDatum->type == dat_sharedStr &&
+	 (__atomic_load_n(&strBuf(pDatum->u.longStr.ptr)->refCount, __ATOMIC_RELAXED) & StrBufSym);
+	}
+
+// Return true if two shared strings are symbols interned in the same symbol table, otherwise false.
+static bool sameSymTab(char *str1, char *str2) {
+
+	return (__atomic_load_n(&strBuf(str1)->refCount, __ATOMIC_RELAXED) & StrBufSym) &&
+	 (__atomic_load_n(&strBuf(str2)->refCount, __ATOMIC_RELAXED) & StrBufSym) &&
+	 symBuf(str1)->tabID == symBuf(str2)->tabID;
 	}
 
 // Convert a character to a string and store in a datum.
 void dconvchr(short c, Datum *pDatum) {
 
 	dsetnull(pDatum);
-	pDatum->u.miniStr[0] = c;
-	pDatum->u.miniStr[1] = '\0';
+	miniStr(pDatum)[0] = c;
+	miniStr(pDatum)[1] = '\0';
 	}
 
 // Transfer contents of one Datum object to another.
 void dxfer(Datum *pDest, Datum *pSrc) {
-	Datum *pDatum = pDest->next;			// Save the "next" pointer...
+	uchar flags = pDest->flags;			// Save the flags...
 	dclear(pDest);					// free dest...
 	*pDest = *pSrc;					// copy the whole burrito...
-	pDest->next = pDatum;				// restore "next" pointer...
-	if(pDest->type == dat_miniStr)			// fix mini-string pointer...
-		pDest->str = pDest->u.miniStr;
-	dinit(pSrc);					// and initialize the source (discard contents).
+	pDest->flags = flags;				// restore flags...
+	dsetnilval(pSrc);				// and initialize the source (discard contents).
 	}
 
-// Return true if a Datum object is a null string, otherwise false.
+// Return true if a Datum object is a null string or zero-length substring reference, otherwise false.
 bool disnull(const Datum *pDatum) {
 
-	return dtypstr(pDatum) && *pDatum->str == '\0';
+	return dtypstr(pDatum) ? *dstr(pDatum) == '\0' : pDatum->type == dat_substrRef && pDatum->u.mem.size == 0;
 	}
 
 // Return true if a Datum object is empty (is nil, a null string, or a zero-element array), otherwise false.
@@ -333,23 +768,34 @@ bool disempty(const Datum *pDatum) {
 // Create Datum object and set *ppDatum to it.  If 'track' is true, add it to the garbage collection stack.  Return status code.
 static int dmake(Datum **ppDatum, bool track) {
 	Datum *pDatum;
+	DGarbCtx *pCtx = dgarbctx();
 
-	// Get new object...
-	if((pDatum = (Datum *) malloc(sizeof(Datum))) == NULL) {
+	// Get new object from pool or heap...
+	if(pCtx->pool != NULL) {
+		PoolDatum *pPoolDatum = (PoolDatum *) pCtx->pool;
+
+		pCtx->pool = (void *) pPoolDatum->next;
+		--pCtx->poolCount;
+		pDatum = (Datum *) pPoolDatum;
+		}
+	else if((pDatum = (Datum *) malloc(sizeof(Datum))) == NULL) {
 		cxlExcep.flags |= ExcepMem;
 		return emsgsys(-1);
 		}
 
 	// add it to garbage collection stack (if applicable)...
 	if(track) {
-		pDatum->next = datGarbHead;
-		datGarbHead = pDatum;
+		if(garbPush(pCtx, pDatum) != 0) {
+			poolPut(pCtx, pDatum);
+			return -1;
+			}
+		pDatum->flags = DFTracked | DFListed;
 		}
 	else
-		pDatum->next = NULL;
+		pDatum->flags = 0;
 
 	// initialize it...
-	dinit(pDatum);
+	dsetnilval(pDatum);
 
 	// and return the spoils.
 	*ppDatum = pDatum;
@@ -368,30 +814,85 @@ int dnewtrack(Datum **ppDatum) {
 	return dmake(ppDatum, true);
 	}
 
-// Copy a byte string into a fabrication object's work buffer, left or right justified.  Source string may already be in the
-// buffer.
-static void fabCopy(DFab *pFab, const char *str, size_t len) {
-
-	if(len > 0) {
-		if((pFab->flags & FabModeMask) != FabPrepend) {
+// Concatenate the pieces of a rope and save the result in a Datum object as a string or byte string according to 'type', which
+// may be any dclose() type except FabRope.  The pieces are checked for imbedded null bytes only if mayBeBinary is true.  The
+// Datum object may be the one holding the rope, in which case the rope is freed if successful.  Return status code.
+static int ropeFlatten(const DRope *pRope, Datum *pDatum, ushort type, bool mayBeBinary) {
+	const DMem *pPiece = pRope->pieces;
+	const DMem *pPieceEnd = pPiece + pRope->count;
+	char *str, *str0;
+	size_t len = pRope->size;
+	bool isBinary = false;
+	char workBuf[DMiniSize];
+
+	// Get space for concatenated pieces (as a shared string if not a mini).
+	if(shalloc(&str0, len + 1, workBuf) != 0)
+		return -1;
 
-			// Appending to existing byte string: copy it into the work buffer.
-			pFab->bufCur = (char *) memstpcpy((void *) pFab->buf, (void *) str, len);
+	// Copy pieces into it and check for any imbedded null bytes.
+	for(str = str0; pPiece < pPieceEnd; ++pPiece) {
+		if(mayBeBinary && !isBinary && memchr(pPiece->ptr, '\0', pPiece->size) != NULL)
+			isBinary = true;
+		str = (char *) memstpcpy((void *) str, pPiece->ptr, pPiece->size);
+		}
+	*str = '\0';
+
+	// Set byte string in Datum object if able.  If result is not a shared string, move it to the beginning of its buffer
+	// first so that it can be passed to free().
+	if(isBinary && type & (FabStr | FabStrRef)) {
+		if(str0 != workBuf)
+			free((void *) strBuf(str0));
+		return emsg(-1, "Cannot convert binary data to string");
+		}
+	if(str0 != workBuf && (isBinary || type & (FabMem | FabMemRef | FabStrRef)))
+		str0 = (char *) memmove((void *) strBuf(str0), (void *) str0, len + 1);
+	if(isBinary || type & (FabMem | FabMemRef)) {
+		if(str0 == workBuf) {			// "Mini" byte string in workBuf.
+			if(dsetmem((void *) workBuf, len, pDatum) != 0)
+				return -1;
+			if(type == FabMemRef)
+				pDatum->type = dat_byteStrRef;
+			}
+		else {					// Byte string in memory.
+			dsetmemref((void *) str0, len, pDatum);
+			if(type != FabMemRef)
+				pDatum->type = dat_byteStr;
+			}
+		}
+	else if(str0 == workBuf) {			// Mini-string in workBuf.
+		if(type == FabStrRef) {
+			if(salloc(&str, len + 1, NULL) != 0)
+				return -1;
+			setStrRef(str, len, pDatum, dat_longStrRef);
 			}
 		else {
-			// Prepending to existing byte string or right-shifting the data in the work buffer.
-			char *dest = pFab->bufEnd;
-			str += len;
-			do {
-				*--dest = *--str;
-				} while(--len > 0);
-			pFab->bufCur = dest;
+			dsetnull(pDatum);
+			str = miniStr(pDatum);
 			}
+		strcpy(str, workBuf);
+		}
+	else						// Long string in memory.
+		setStrRef(str0, len, pDatum, type == FabStrRef ? dat_longStrRef : dat_sharedStr);
+
+	return 0;
+	}
+
+// Convert a rope or substring reference in a Datum object to a string, or a byte string if it contains any null bytes.  Datum
+// objects of any other type are left as is.  Return status code.
+int dflatten(Datum *pDatum) {
+
+	if(pDatum->type == dat_substrRef) {
+		DMem mem = pDatum->u.mem;
+
+		return memchr(mem.ptr, '\0', mem.size) != NULL ? dsetmem(mem.ptr, mem.size, pDatum) :
+		 setSubstr((char *) mem.ptr, mem.size, pDatum);
 		}
+	return pDatum->type == dat_rope ? ropeFlatten(pDatum->u.pRope, pDatum, FabAuto, true) : 0;
 	}
 
-// Save a byte string to a fabrication object's chunk list.  Return status code.
-static int fabSave(char *str, size_t len, DFab *pFab) {
+// Add a byte string (which can be passed to free()) to a fabrication object's chunk list, at the beginning if prepending,
+// otherwise the end.  Return status code.
+static int chunkAdd(void *ptr, size_t len, DFab *pFab) {
 	DChunk *pChunk;
 
 	// Get new chunk...
@@ -399,21 +900,49 @@ static int fabSave(char *str, size_t len, DFab *pFab) {
 		cxlExcep.flags |= ExcepMem;
 		return emsgsys(-1);
 		}
-	pChunk->mem.ptr = (void *) str;
+	pChunk->mem.ptr = ptr;
 	pChunk->mem.size = len;
 
-	// and push it onto the stack in the fabrication object.
-	pChunk->next = pFab->stack;
-	pFab->stack = pChunk;
+	// and link it into the list in the fabrication object.
+	if((pFab->flags & FabModeMask) == FabPrepend) {
+		if((pChunk->next = pFab->chunks) == NULL)
+			pFab->lastChunk = pChunk;
+		pFab->chunks = pChunk;
+		}
+	else {
+		pChunk->next = NULL;
+		if(pFab->chunks == NULL)
+			pFab->chunks = pChunk;
+		else
+			pFab->lastChunk->next = pChunk;
+		pFab->lastChunk = pChunk;
+		}
 
 	return 0;
 	}
 
-// Grow work buffer in a fabrication object.  Assume minSize is less than ChunkSizeMax.  If not initial allocation and
-// prepending, the data in the work buffer is shifted right after the work buffer is extended.  Return status code.
+// Save the data in a fabrication object's work buffer to its chunk list and give up the buffer.  The data is moved to the
+// beginning of the buffer first if needed so that it can be passed to free() later.  Return status code.
+static int fabSave(DFab *pFab) {
+	size_t len = pFab->dataEnd - pFab->dataBeg;
+
+	if(pFab->dataBeg != pFab->buf)
+		memmove((void *) pFab->buf, (void *) pFab->dataBeg, len);
+	if(chunkAdd((void *) pFab->buf, len, pFab) != 0)
+		return -1;
+	pFab->buf = NULL;
+	return 0;
+	}
+
+// Grow work buffer in a fabrication object so that there is room to write at least one more byte at the end of the data, or
+// the beginning if prepending.  Assume minSize is less than ChunkSizeMax.  If not initial allocation, the buffer is extended
+// and if prepending, the data in the work buffer is shifted right by the size of the extension.  If the buffer is already at
+// maximum size, it is saved as a chunk and a new one is allocated, unless the FabSingle flag is set, in which case it keeps
+// doubling in size.  Return status code.
 static int fabGrow(DFab *pFab, size_t minSize) {
 	char *buf;
-	size_t size, used;
+	size_t size, oldSize, beg, end;
+	bool prepend = (pFab->flags & FabModeMask) == FabPrepend;
 
 	// Initial allocation?
 	if(pFab->buf == NULL) {
@@ -421,109 +950,239 @@ static int fabGrow(DFab *pFab, size_t minSize) {
 		goto Init;
 		}
 
-	// Nope... called from putchr().  Work buffer is full.
+	// Nope... called from a put routine.  Double or quadruple old size?
+	size = oldSize = pFab->bufEnd - pFab->buf;
+	if(size < ChunkSize4)
+		size *= 2;
+	else if(size < ChunkSizeMax)
+		size *= 4;
+
+	// Growing a single buffer?  Double it (realloc() can usually do this by remapping pages for large sizes).
+	else if(pFab->flags & FabSingle)
+		size *= 2;
+
+	// No, already at max.  Save current buffer and allocate new one.
 	else {
-		// Double or quadruple old size?
-		size = used = pFab->bufEnd - (buf = pFab->buf);
-		if(size < ChunkSize4)
-			size *= 2;
-		else if(size < ChunkSizeMax)
-			size *= 4;
-
-		// No, already at max.  Save current buffer and allocate new one.
-		else {
-			if(fabSave(buf, size, pFab) != 0)
-				return -1;
+		if(fabSave(pFab) != 0)
+			return -1;
 Init:
-			buf = NULL;
-			used = 0;
-			}
+		if((buf = (char *) malloc(size)) == NULL)
+			goto Err;
+		pFab->bufEnd = (pFab->buf = buf) + size;
+		pFab->dataBeg = pFab->dataEnd = prepend ? pFab->bufEnd : buf;
+		return 0;
 		}
 
-	// Get more space and reset pointers.
-	if((pFab->buf = (char *) realloc((void *) buf, size)) == NULL) {
+	// Extend old buffer and reset pointers.
+	beg = pFab->dataBeg - pFab->buf;
+	end = pFab->dataEnd - pFab->buf;
+	if((buf = (char *) realloc((void *) pFab->buf, size)) == NULL) {
+Err:
 		cxlExcep.flags |= ExcepMem;
 		return emsgsys(-1);
 		}
-	pFab->bufEnd = pFab->buf + size;
-	if((pFab->flags & FabModeMask) != FabPrepend)
-		pFab->bufCur = pFab->buf + used;
-	else {
-		pFab->bufCur = pFab->bufEnd - used;
-		if(buf != NULL)
+	pFab->bufEnd = (pFab->buf = buf) + size;
+	if(prepend) {
 
-			// Extended old buffer in "prepend" mode... right-shift contents.
-			fabCopy(pFab, pFab->buf, used);
+		// Extended old buffer in "prepend" mode... right-shift contents.
+		size -= oldSize;
+		pFab->dataBeg = (char *) memmove((void *) (buf + beg + size), (void *) (buf + beg), end - beg);
+		pFab->dataEnd = buf + end + size;
+		}
+	else {
+		pFab->dataBeg = buf + beg;
+		pFab->dataEnd = buf + end;
 		}
 
 	return 0;
 	}
 
-// Check for fab-prepending errors and return status code.  pDatum may be NULL.
-static int flagsCheck(const Datum *pDatum, DFab *pFab, ushort cflags) {
+// Initialize work buffer in a fabrication object for a new build with room for at least minSize bytes (which is assumed to be
+// less than ChunkSizeMax), reusing the buffer retained from a prior build if it is large enough.  Return status code.
+static int fabInit(DFab *pFab, size_t minSize) {
 
-	if((pFab->flags & FabModeMask) == FabPrepend) {
-		if(cflags)
-			return emsg(-1, "Conversion flags not allowed when fab-prepending");
-		if(pDatum != NULL && !(pDatum->type & (DStrMask | DMemMask)))
-			return emsg(-1, "Cannot fab-prepend non-string datum");
+	if(pFab->buf != NULL) {
+		if((size_t) (pFab->bufEnd - pFab->buf) >= minSize) {
+			pFab->dataBeg = pFab->dataEnd = ((pFab->flags & FabModeMask) == FabPrepend) ? pFab->bufEnd : pFab->buf;
+			return 0;
+			}
+		free((void *) pFab->buf);
+		pFab->buf = NULL;
+		}
+	return fabGrow(pFab, minSize);
+	}
+
+// Release the work buffer in a fabrication object after its contents have been copied, unless the object is reusable.
+static void fabDone(DFab *pFab) {
+
+	if(!(pFab->flags & FabReuse)) {
+		free((void *) pFab->buf);
+		pFab->buf = NULL;
 		}
-	return 0;
 	}
 
 // Low level routine to put a character to a fabrication object.  Return status code.
 int bputc(short c, DFab *pFab) {
 
+	if(c == '\0')
+		pFab->flags |= FabBinary;
+
 	if((pFab->flags & FabModeMask) == FabPrepend) {
 
-		// Save current chunk if no space left.
-		if(pFab->bufCur == pFab->buf && fabGrow(pFab, 0) != 0)
+		// Grow work buffer if no space left.
+		if(pFab->dataBeg == pFab->buf && fabGrow(pFab, 0) != 0)
 			return -1;
 
 		// Save the character.
-		*--pFab->bufCur = c;
+		*--pFab->dataBeg = c;
 		}
 	else {
-		// Save current chunk if no space left.
-		if(pFab->bufCur == pFab->bufEnd && fabGrow(pFab, 0) != 0)
+		// Grow work buffer if no space left.
+		if(pFab->dataEnd == pFab->bufEnd && fabGrow(pFab, 0) != 0)
 			return -1;
 
 		// Save the character.
-		*pFab->bufCur++ = c;
+		*pFab->dataEnd++ = c;
 		}
 
 	return 0;
 	}
 
-// Low level routine to put a null-terminated string to a fabrication object.  Return status code.
-int bputs(const char *str, DFab *pFab) {
+// Low level routine to put a substring to a fabrication object.  Bytes are block-copied into the free space in the work
+// buffer, which is grown (or saved as a chunk when full) as often as needed.  Return status code.
+static int bputss(const char *strBegin, const char *strEnd, DFab *pFab) {
+	size_t len, n;
 
 	if((pFab->flags & FabModeMask) == FabPrepend) {
-		char *str1 = strchr(str, '\0');
-		while(str1 > str)
-			if(bputc(*--str1, pFab) != 0)
+		while((len = strEnd - strBegin) > 0) {
+
+			// Grow work buffer if no space left.
+			if(pFab->dataBeg == pFab->buf && fabGrow(pFab, 0) != 0)
 				return -1;
+
+			// Copy as much of the tail of the string as will fit.
+			if((n = pFab->dataBeg - pFab->buf) > len)
+				n = len;
+			strEnd -= n;
+			memcpy((void *) (pFab->dataBeg -= n), (void *) strEnd, n);
+			}
 		}
 	else {
-		while(*str != '\0')
-			if(bputc(*str++, pFab) != 0)
+		while((len = strEnd - strBegin) > 0) {
+
+			// Grow work buffer if no space left.
+			if(pFab->dataEnd == pFab->bufEnd && fabGrow(pFab, 0) != 0)
 				return -1;
+
+			// Copy as much of the head of the string as will fit.
+			if((n = pFab->bufEnd - pFab->dataEnd) > len)
+				n = len;
+			pFab->dataEnd = (char *) memstpcpy((void *) pFab->dataEnd, (void *) strBegin, n);
+			strBegin += n;
+			}
 		}
 	return 0;
 	}
 
-// Low level routine to put a substring to a fabrication object.  Return status code.
-static int bputss(const char *strBegin, const char *strEnd, DFab *pFab) {
+// Low level routine to put a null-terminated string to a fabrication object.  Return status code.
+int bputs(const char *str, DFab *pFab) {
 
-	if((pFab->flags & FabModeMask) == FabPrepend) {
-		while(strEnd > strBegin)
-			if(bputc(*--strEnd, pFab) != 0)
-				return -1;
+	return bputss(str, strchr(str, '\0'), pFab);
+	}
+
+// Low level routine to put a byte string to a fabrication object, noting if it contains any null bytes so that dclose() does
+// not need to scan the data for them.  Return status code.
+static int bputmem(const char *strBegin, const char *strEnd, DFab *pFab) {
+
+	if(!(pFab->flags & FabBinary) && strEnd > strBegin && memchr((void *) strBegin, '\0', strEnd - strBegin) != NULL)
+		pFab->flags |= FabBinary;
+	return bputss(strBegin, strEnd, pFab);
+	}
+
+// Low level routine to open a temporary fabrication object for writing a conversion from left to right, so that the result can
+// be prepended to another fabrication object by bputfab().  The calling thread's reusable temporary object, which keeps its work
+// buffer between uses, is opened unless it is already in use, in which case *pFab is opened with dopen() instead.  Return
+// pointer to the open object, or NULL if error.
+DFab *bopentemp(DFab *pFab) {
+
+	if(!tempFabOpen) {
+		if(dopenreuse(&tempFab, &tempDatum, FabClear) != 0)
+			return NULL;
+		tempFabOpen = true;
+		return &tempFab;
 		}
-	else {
-		while(strBegin < strEnd)
-			if(bputc(*strBegin++, pFab) != 0)
+	return (dopen(pFab) != 0) ? NULL : pFab;
+	}
+
+// Low level routine to close a temporary fabrication object that was opened by bopentemp(), put its contents to another
+// fabrication object if rtnCode is not negative (the status of the writes to the temporary object), and release it.  This is
+// used to prepend the output of a conversion that is written in pieces from left to right.  Return rtnCode, or -1 if error.
+int bputfab(DFab *pSrcFab, DFab *pFab, int rtnCode) {
+	Datum *pDatum = pSrcFab->pDatum;
+
+	pFab->flags |= pSrcFab->flags & FabBinary;
+
+	// Thread's reusable object?  Put the data in its work buffer (which is last) and then its saved chunks, last to first,
+	// directly.  The chunks are released and the work buffer is kept for the next use.
+	if(pSrcFab == &tempFab) {
+		DChunk *pChunk, *pNext;
+		DChunk *pPrev = NULL;
+
+		if(rtnCode >= 0 && bputss(tempFab.dataBeg, tempFab.dataEnd, pFab) != 0)
+			rtnCode = -1;
+		for(pChunk = tempFab.chunks; pChunk != NULL; pChunk = pNext) {	// Reverse the chunk list.
+			pNext = pChunk->next;
+			pChunk->next = pPrev;
+			pPrev = pChunk;
+			}
+		for(pChunk = pPrev; pChunk != NULL; pChunk = pNext) {
+			pNext = pChunk->next;
+			if(rtnCode >= 0 && bputss(pChunk->mem.ptr, pChunk->mem.ptr + pChunk->mem.size, pFab) != 0)
+				rtnCode = -1;
+			free(pChunk->mem.ptr);
+			free((void *) pChunk);
+			}
+		tempFab.chunks = NULL;
+		tempFabOpen = false;
+		return rtnCode;
+		}
+
+	if(dclose(pSrcFab, FabRope) != 0)
+		rtnCode = -1;
+	else if(rtnCode >= 0) {
+		DRope *pRope = pDatum->u.pRope;
+		const DMem *pPiece = pRope->pieces + pRope->count;
+
+		// Put pieces last to first (which is the correct order for prepending).
+		while(pPiece-- > pRope->pieces)
+			if(bputss(pPiece->ptr, pPiece->ptr + pPiece->size, pFab) != 0) {
+				rtnCode = -1;
+				break;
+				}
+		}
+	dfree(pDatum);
+	return rtnCode;
+	}
+
+// Change the direction in which data is written to an open fabrication object to FabAppend or FabPrepend.  Data may be appended
+// and prepended to the same object in any order.  Return status code.
+int dfabmode(DFab *pFab, ushort mode) {
+
+	if(mode != FabAppend && mode != FabPrepend)
+		return emsgf(-1, "Invalid fabrication mode, %hu", mode);
+	if(((pFab->flags & FabModeMask) == FabPrepend) != (mode == FabPrepend)) {
+
+		// If any chunks were saved, the work buffer is at the wrong end of the data, so save it as well (if not empty)
+		// and start a new one at the other end.  Otherwise, just write at the other end of the data in the work buffer.
+		if(pFab->chunks != NULL && pFab->dataEnd > pFab->dataBeg) {
+			if(fabSave(pFab) != 0)
 				return -1;
+			pFab->flags = (pFab->flags & ~FabModeMask) | mode;
+			return fabGrow(pFab, 0);
+			}
+		pFab->flags = (pFab->flags & ~FabModeMask) | mode;
+		if(pFab->chunks != NULL)
+			pFab->dataBeg = pFab->dataEnd = (mode == FabPrepend) ? pFab->bufEnd : pFab->buf;
 		}
 	return 0;
 	}
@@ -533,86 +1192,136 @@ static int bputss(const char *strBegin, const char *strEnd, DFab *pFab) {
 int dunputc(DFab *pFab) {
 
 	// Any bytes in work buffer?
-	if((pFab->flags & FabModeMask) == FabPrepend) {
-		if(pFab->bufCur < pFab->bufEnd)
-			return *pFab->bufCur++;
-		}
-	else if(pFab->bufCur > pFab->buf)
-		return *--pFab->bufCur;
+	if(pFab->dataBeg < pFab->dataEnd)
+		return ((pFab->flags & FabModeMask) == FabPrepend) ? *pFab->dataBeg++ : *--pFab->dataEnd;
 
 	// Empty buffer.  Return error.
 	return emsg(-1, "No characters left to \"unput\"");
 	}
 
-// "Quote put" a substring or byte string to a fabrication object per cflags and return status code.  If any flags are specified
-// and prepending, return an error (not supported).  If DCvtQuote1, DCvtQuote2, or DCvtQuote flag is specified, single (if
-// DCvtQuote1 flag) or double (otherwise) quote characters (' or ") are added to beginning and end of converted string, with
-// DCvtQuote1 flag taking precedence.  If DCvtEscChar flag is specified, backslashes, double quote characters ("), and
-// non-printable characters are escaped; otherwise, if DCvtVizChar or any Viz* flag is specified, all characters are copied in
-// visible form via calls to vizc() function; otherwise, string is copied literatim (raw).
+// Escape sequences for DCvtEscChar conversions, indexed by character.  A null string indicates that the character is copied
+// literally.
+static const char escTable[256][5] = {
+	"\\000", "\\001", "\\002", "\\003", "\\004", "\\005", "\\006", "\\007",
+	"\\b", "\\t", "\\n", "\\v", "\\f", "\\r", "\\016", "\\017",
+	"\\020", "\\021", "\\022", "\\023", "\\024", "\\025", "\\026", "\\027",
+	"\\030", "\\031", "\\032", "\\e", "\\034", "\\035", "\\036", "\\037",
+	"", "", "\\\"", "", "", "", "", "",
+	"", "", "", "", "", "", "", "",
+	"", "", "", "", "", "", "", "",
+	"", "", "", "", "", "", "", "",
+	"", "", "", "", "", "", "", "",
+	"", "", "", "", "", "", "", "",
+	"", "", "", "", "", "", "", "",
+	"", "", "", "", "\\\\", "", "", "",
+	"", "", "", "", "", "", "", "",
+	"", "", "", "", "", "", "", "",
+	"", "", "", "", "", "", "", "",
+	"", "", "", "", "", "", "", "\\177",
+	"\\200", "\\201", "\\202", "\\203", "\\204", "\\205", "\\206", "\\207",
+	"\\210", "\\211", "\\212", "\\213", "\\214", "\\215", "\\216", "\\217",
+	"\\220", "\\221", "\\222", "\\223", "\\224", "\\225", "\\226", "\\227",
+	"\\230", "\\231", "\\232", "\\233", "\\234", "\\235", "\\236", "\\237",
+	"\\240", "\\241", "\\242", "\\243", "\\244", "\\245", "\\246", "\\247",
+	"\\250", "\\251", "\\252", "\\253", "\\254", "\\255", "\\256", "\\257",
+	"\\260", "\\261", "\\262", "\\263", "\\264", "\\265", "\\266", "\\267",
+	"\\270", "\\271", "\\272", "\\273", "\\274", "\\275", "\\276", "\\277",
+	"\\300", "\\301", "\\302", "\\303", "\\304", "\\305", "\\306", "\\307",
+	"\\310", "\\311", "\\312", "\\313", "\\314", "\\315", "\\316", "\\317",
+	"\\320", "\\321", "\\322", "\\323", "\\324", "\\325", "\\326", "\\327",
+	"\\330", "\\331", "\\332", "\\333", "\\334", "\\335", "\\336", "\\337",
+	"\\340", "\\341", "\\342", "\\343", "\\344", "\\345", "\\346", "\\347",
+	"\\350", "\\351", "\\352", "\\353", "\\354", "\\355", "\\356", "\\357",
+	"\\360", "\\361", "\\362", "\\363", "\\364", "\\365", "\\366", "\\367",
+	"\\370", "\\371", "\\372", "\\373", "\\374", "\\375", "\\376", "\\377",
+	};
+
+// Return pointer to the first character in str (before strEnd) which must be escaped for a DCvtEscChar conversion, or strEnd
+// if none.  The string is scanned eight bytes at a time.
+static const char *escSpan(const char *str, const char *strEnd) {
+	uint64_t x;
+
+	while(strEnd - str >= 8) {
+		memcpy((void *) &x, (void *) str, sizeof(x));
+		if((x & SwarHighs) | SwarLess(x, ' ') | SwarHas(x, 0x7F) | SwarHas(x, '"') | SwarHas(x, '\\'))
+			break;
+		str += 8;
+		}
+	while(str < strEnd && escTable[(uchar) *str][0] == '\0')
+		++str;
+	return str;
+	}
+
+// Return pointer to the first character in str (before strEnd) which vizc() converts to visible form per cflags, or strEnd if
+// none.  The string is scanned eight bytes at a time.
+static const char *vizSpan(const char *str, const char *strEnd, ushort cflags) {
+	uint64_t x;
+	uchar minChar = (cflags & VizSpace) ? ' ' + 1 : ' ';
+
+	while(strEnd - str >= 8) {
+		memcpy((void *) &x, (void *) str, sizeof(x));
+		if((x & SwarHighs) | SwarLess(x, minChar) | SwarHas(x, 0x7F))
+			break;
+		str += 8;
+		}
+	while(str < strEnd && (uchar) *str >= minChar && (uchar) *str < 0x7F)
+		++str;
+	return str;
+	}
+
+// "Quote put" a substring or byte string to a fabrication object per cflags and return status code.  If DCvtQuote1, DCvtQuote2,
+// or DCvtQuote flag is specified, single (if DCvtQuote1 flag) or double (otherwise) quote characters (' or ") are added to
+// beginning and end of converted string, with DCvtQuote1 flag taking precedence.  If DCvtEscChar flag is specified, backslashes,
+// double quote characters ("), and non-printable characters are escaped; otherwise, if DCvtVizChar or any Viz* flag is specified,
+// all characters are copied in visible form via calls to vizc() function; otherwise, string is copied literatim (raw).
 static int qput(const char *str, const char *strEnd, DFab *pFab, ushort cflags) {
-        short c, qChar;
-	bool isChar;
-	char *str1;
-	char workBuf[8];
+	short qChar;
+	const char *str1;
 
-	if(flagsCheck(NULL, pFab, cflags) != 0)
-		return -1;
+	// If prepending and conversion is needed, write string to a temporary fabrication object (from left to right) and
+	// prepend the result.
+	if((pFab->flags & FabModeMask) == FabPrepend && (cflags & (DCvtQuoteMask | DCvtEscChar | DCvtVizChar | VizMask))) {
+		DFab fab, *pTempFab;
+
+		return (pTempFab = bopentemp(&fab)) == NULL ? -1 : bputfab(pTempFab, pFab, qput(str, strEnd, pTempFab, cflags));
+		}
 
 	qChar = cflags & DCvtQuote1 ? '\'' : cflags & DCvtQuote2 ? '"' :
 	 cflags & DCvtQuote ? (cflags & (DCvtVizChar | VizMask) ? '\'' : '"') : 0;
+	if(qChar && bputc(qChar, pFab) != 0)
+		return -1;
 
 	// Handle non-escaped cases.
 	if(!(cflags & DCvtEscChar)) {
 
-		// Put string with optional "viz" conversion and/or quote-wrap.
-		if(qChar && bputc(qChar, pFab) != 0)
-			return -1;
+		// Put string with optional "viz" conversion.  Runs of characters that don't need conversion are copied as
+		// blocks.
 		if(!(cflags & (DCvtVizChar | VizMask))) {
-			if(bputss(str, strEnd, pFab) != 0)
+			if(bputmem(str, strEnd, pFab) != 0)
 				return -1;
 			}
 		else {
-			while(str < strEnd)
-				if(bputs(vizc(*str++, cflags), pFab) != 0)
+			for(;;) {
+				if(bputss(str, str1 = vizSpan(str, strEnd, cflags), pFab) != 0)
+					return -1;
+				if(str1 == strEnd)
+					break;
+				if((str = vizc(*str1, cflags)) == NULL || bputs(str, pFab) != 0)
 					return -1;
+				str = str1 + 1;
+				}
 			}
 		}
 	else {
-		// Escaped-char case.  Copy and escape string.
-		if((c = qChar))
-			goto LitChar;
-
-		while(str < strEnd) {
-			isChar = false;
-			switch(c = *str++) {
-				case '"':				// Double quote
-					str1 = "\\\""; break;
-				case '\\':				// Backslash
-					str1 = "\\\\"; break;
-				case '\r':				// CR
-					str1 = "\\r"; break;
-				case '\n':				// NL
-					str1 = "\\n"; break;
-				case '\t':				// Tab
-					str1 = "\\t"; break;
-				case '\b':				// Backspace
-					str1 = "\\b"; break;
-				case '\f':				// Form feed
-					str1 = "\\f"; break;
-				case '\v':				// Vertical tab
-					str1 = "\\v"; break;
-				case 033:				// Escape
-					str1 = "\\e"; break;
-				default:
-					if(c < ' ' || c >= 0x7F)	// Non-printable character.
-						sprintf(str1 = workBuf, "\\%.3ho", c);
-					else				// Literal character.
-LitChar:
-						isChar = true;
-				}
-			if((isChar ? bputc(c, pFab) : bputs(str1, pFab)) != 0)
+		// Escaped-char case.  Copy runs of literal characters as blocks and escape the rest.
+		for(;;) {
+			if(bputss(str, str1 = escSpan(str, strEnd), pFab) != 0)
+				return -1;
+			if(str1 == strEnd)
+				break;
+			if(bputs(escTable[(uchar) *str1], pFab) != 0)
 				return -1;
+			str = str1 + 1;
 			}
 		}
 
@@ -623,9 +1332,6 @@ LitChar:
 // Put a character to a fabrication object per cflags.  Return status code.
 int dputc(short c, DFab *pFab, ushort cflags) {
 
-	if(flagsCheck(NULL, pFab, cflags) != 0)
-		return -1;
-
 	// Do vizc() conversion here if no other conversion needed.
 	if((cflags & (DCvtVizChar | VizMask)) && !(cflags & ~(DCvtVizChar | VizMask)))
 		return bputs(vizc(c, cflags), pFab);
@@ -644,15 +1350,16 @@ int dputc(short c, DFab *pFab, ushort cflags) {
 // Put a string to a fabrication object per cflags.  Return status code.
 int dputs(const char *str, DFab *pFab, ushort cflags) {
 
-	return qput(str, strchr(str, '\0'), pFab, cflags);
+	return cflags ? qput(str, strchr(str, '\0'), pFab, cflags) : bputs(str, pFab);
 	}
 
 // Put a substring (up to "len" characters) to a fabrication object per cflags.  Return status code.
 int dputsubstr(const char *str, size_t len, DFab *pFab, ushort cflags) {
-	const char *str1 = strchr(str, '\0');
-	const char *str2 = str + len;
+	const char *strEnd = (const char *) memchr((void *) str, '\0', len);
 
-	return qput(str, str1 < str2 ? str1 : str2, pFab, cflags);
+	if(strEnd == NULL)
+		strEnd = str + len;
+	return cflags ? qput(str, strEnd, pFab, cflags) : bputss(str, strEnd, pFab);
 	}
 
 // Put "size" bytes in memory to a fabrication object per cflags, and return status code.
@@ -662,11 +1369,11 @@ int dputmem(const void *memPtr, size_t size, DFab *pFab, ushort cflags) {
 	}
 
 // Convert datum in *pSrc to a human-readable string if conditions are met.  If primitive type or character or string not
-// requiring conversion found, save pointer to result in *pDest and return 0; if character or string found and DCvtEscChar,
-// DCvtQuote1, DCvtQuote2, DCvtQuote, DCvtVizChar, or Viz* flag set (requiring a conversion), return 1 or 2, respectively; if
-// array found, return 3; otherwise (byte string found), return 4.
-static int dtos1(char **pDest, const Datum *pSrc, ushort cflags) {
-	static char workBuf[64];
+// requiring conversion found, save pointer to result (which may be in workBuf, a buffer of at least NumBufSize bytes) in
+// *pDest and return 0; if character or string found and DCvtEscChar, DCvtQuote1, DCvtQuote2, DCvtQuote, DCvtVizChar, or Viz*
+// flag set (requiring a conversion), return 1 or 2, respectively; if array found, return 3; if rope found, return 5;
+// otherwise (byte string or substring reference found), return 4.
+static int dtos1(char **pDest, const Datum *pSrc, ushort cflags, char *workBuf) {
 	char *str = workBuf;
 
 	// Check datum type.
@@ -690,27 +1397,30 @@ static int dtos1(char **pDest, const Datum *pSrc, ushort cflags) {
 			if(cflags & DCvtThouSep)
 				str = intf(pSrc->u.intNum);
 			else
-				sprintf(workBuf, "%ld", pSrc->u.intNum);
+				(void) inttos(pSrc->u.intNum, workBuf);
 			break;
 		case dat_uint:
 			if(cflags & DCvtThouSep)
 				str = uintf(pSrc->u.uintNum);
 			else
-				sprintf(workBuf, "%lu", pSrc->u.uintNum);
+				(void) uinttos(pSrc->u.uintNum, workBuf);
 			break;
 		case dat_real:
-			sprintf(workBuf, "%.16lg", pSrc->u.realNum);
+			(void) realtos(pSrc->u.realNum, workBuf);
 			break;
 		case dat_miniStr:
 		case dat_longStr:
 		case dat_longStrRef:
+		case dat_sharedStr:
 			if(cflags & (DCvtQuoteMask | DCvtEscChar | DCvtVizChar | VizMask))
 				return 2;
-			str = pSrc->str;
+			str = dstr(pSrc);
 			break;
 		case dat_array:
 		case dat_arrayRef:
 			return 3;
+		case dat_rope:
+			return 5;
 		default:	/* Byte string */
 			return 4;
 		}
@@ -718,40 +1428,108 @@ static int dtos1(char **pDest, const Datum *pSrc, ushort cflags) {
 	return 0;
 	}
 
+// Write a rope to a fabrication object per cflags.  The pieces are written directly (last to first if prepending) if no
+// conversion is needed; otherwise, a concatenated copy is converted.  Return status code.
+static int ropePut(const DRope *pRope, DFab *pFab, ushort cflags) {
+
+	if(!(cflags & (DCvtQuoteMask | DCvtEscChar | DCvtVizChar | VizMask))) {
+		const DMem *pPiece = pRope->pieces;
+		const DMem *pPieceEnd = pPiece + pRope->count;
+
+		if((pFab->flags & FabModeMask) == FabPrepend) {
+			while(pPieceEnd-- > pPiece)
+				if(bputmem(pPieceEnd->ptr, pPieceEnd->ptr + pPieceEnd->size, pFab) != 0)
+					return -1;
+			}
+		else {
+			for(; pPiece < pPieceEnd; ++pPiece)
+				if(bputmem(pPiece->ptr, pPiece->ptr + pPiece->size, pFab) != 0)
+					return -1;
+			}
+		return 0;
+		}
+	else {
+		Datum datum;
+		int rtnCode;
+
+		dinit(&datum);
+		rtnCode = (ropeFlatten(pRope, &datum, FabAuto, true) != 0) ? -1 : dputd(&datum, pFab, NULL, cflags);
+		dclear(&datum);
+		return rtnCode;
+		}
+	}
+
 // Write a Datum object to a fabrication object in string form, per cflags, and return status code.
 int dputd(const Datum *pDatum, DFab *pFab, const char *delim, ushort cflags) {
 	char *str;
+	char workBuf[NumBufSize];
 
-	if(flagsCheck(pDatum, pFab, cflags) != 0)
-		return -1;
-	switch(dtos1(&str, pDatum, cflags)) {
+	switch(dtos1(&str, pDatum, cflags, workBuf)) {
 		case 0:		// Keyword or simple string.
-			return bputs(str, pFab);
+			return dtypstr(pDatum) ? bputss(str, str + dstrlen(pDatum), pFab) : bputs(str, pFab);
 		case 1:		// Character conversion.
 			return dputc(pDatum->u.c, pFab, cflags);
 		case 2:		// String conversion.
-			return dputs(pDatum->str, pFab, cflags);
+			str = dstr(pDatum);
+			return qput(str, str + dstrlen(pDatum), pFab, cflags);
 		case 3:		// Array.
 			return aput(pDatum->u.pArray, pFab, delim, cflags);
+		case 5:		// Rope.
+			return ropePut(pDatum->u.pRope, pFab, cflags);
 		}
 
 	// Byte string.
 	return qput(pDatum->u.mem.ptr, pDatum->u.mem.ptr + pDatum->u.mem.size, pFab, cflags);
 	}
 
-// Put formatted text to a fabrication object.  Return status code.
+// Put formatted text to a fabrication object.  If appending and no conversion is needed, the text is formatted directly into
+// the free space at the end of the work buffer; otherwise (or if it does not fit), it is formatted into a local buffer, or a
+// heap buffer if too long for that, and put from there.  Return status code.
 int dputf(DFab *pFab, ushort cflags, const char *fmt, ...) {
+	int len, rtnCode;
 	char *str;
-	va_list varArgList;
-
+	size_t size;
+	va_list varArgList, varArgList1;
+	char workBuf[256];
+
+	// Get target buffer and format text into it.
+	if(cflags == 0 && (pFab->flags & FabModeMask) != FabPrepend) {
+		str = pFab->dataEnd;
+		size = pFab->bufEnd - str;
+		}
+	else {
+		str = workBuf;
+		size = sizeof(workBuf);
+		}
 	va_start(varArgList, fmt);
-	(void) vasprintf(&str, fmt, varArgList);
+	va_copy(varArgList1, varArgList);
+	len = vsnprintf(str, size, fmt, varArgList1);
+	va_end(varArgList1);
+
+	// Text didn't fit?  Format it again into a buffer that is big enough.
+	if(len >= 0 && (size_t) len >= size) {
+		if((size_t) len < sizeof(workBuf))
+			str = workBuf;
+		else if((str = (char *) malloc(len + 1)) == NULL) {
+			va_end(varArgList);
+			cxlExcep.flags |= ExcepMem;
+			return emsgsys(-1);
+			}
+		len = vsnprintf(str, len + 1, fmt, varArgList);
+		}
 	va_end(varArgList);
-	if(str == NULL)
+	if(len < 0)
 		return emsgsys(-1);
 
-	int rtnCode = dputs(str, pFab, cflags);
-	free((void *) str);
+	// Text is in work buffer?  If so, just advance the end of the data past it (stopping at any null byte, as dputs()
+	// does).  Otherwise, put it from the other buffer.
+	if(str == pFab->dataEnd) {
+		pFab->dataEnd += strlen(str);
+		return 0;
+		}
+	rtnCode = dputs(str, pFab, cflags);
+	if(str != workBuf)
+		free((void *) str);
 	return rtnCode;
 	}
 
@@ -759,11 +1537,13 @@ int dputf(DFab *pFab, ushort cflags, const char *fmt, ...) {
 // Datum object, and fflags.  If pDatum is NULL, create a new Datum object (which can be retrieved by the caller from the DFab
 // record).  If the FabTrack flag is set, create a tracked object, otherwise untracked.  If pDatum is not NULL and the
 // FabPrepend or FabAppend flag is set, keep existing string value in *pDatum (and prepend or append to it); otherwise, clear
-// it.  Return status code.
+// it.  If the FabReuse flag is set, the work buffer retained in the fabrication object by a prior build (if any) is reused.
+// Return status code.
 static int dprep(DFab *pFab, Datum *pDatum, ushort fflags) {
 
-	pFab->stack = NULL;
-	pFab->buf = NULL;
+	pFab->chunks = NULL;
+	if(!(fflags & FabReuse))
+		pFab->buf = NULL;
 
 	// Initialize Datum object.
 	if(pDatum == NULL) {
@@ -783,26 +1563,38 @@ SetNull:
 
 	// Initialize fabrication buffers, preserving existing string value in Datum object if appending or prepending.
 	if((fflags & FabModeMask) != FabClear) {
-		size_t used = strlen(pDatum->str);
+		size_t used = dstrlen(pDatum);
 		if(used < ChunkSizeMax) {
-			if(fabGrow(pFab, used) != 0)			// Allocate a work buffer.
+			if(fabInit(pFab, used) != 0)			// Get a work buffer.
 				return -1;
 			if(used > 0) {					// If existing string not null...
-				fabCopy(pFab, pDatum->str, used);	// copy it to work buffer, left or right justified...
+				char *str = dstr(pDatum);
+				(void) bputss(str, str + used, pFab);	// copy it to work buffer (which won't fail)...
 				dsetnull(pDatum);			// and set Datum object to null.
 				}
 			return 0;
 			}
 
-		// Appending or prepending to existing string >= ChunkSizeMax in length.  Save it in a DChunk object and
-		// re-initialize Datum object (without calling free()).
-		if(fabSave(pDatum->str, used, pFab) != 0)
+		// Appending or prepending to existing string >= ChunkSizeMax in length.  Save it in a DChunk object, or adopt it
+		// as the (full) work buffer if growing a single buffer, and re-initialize Datum object (without calling free()).
+		// A shared string is converted to an unshared one first.
+		if(pDatum->type == dat_sharedStr && plainStr(pDatum) != 0)
+			return -1;
+		if(fflags & FabSingle) {
+			if(pFab->buf != NULL)
+				free((void *) pFab->buf);
+			pFab->dataEnd = pFab->bufEnd = (pFab->dataBeg = pFab->buf = pDatum->u.longStr.ptr) + used;
+			dsetnilval(pDatum);
+			dsetnull(pDatum);
+			return 0;
+			}
+		if(chunkAdd((void *) pDatum->u.longStr.ptr, used, pFab) != 0)
 			return -1;
-		dinit(pDatum);
+		dsetnilval(pDatum);
 		dsetnull(pDatum);
 		}
 
-	return fabGrow(pFab, 0);
+	return fabInit(pFab, 0);
 	}
 
 // Open a fabrication object via dprep().  An untracked Datum object will be created.  Return status code.
@@ -823,33 +1615,116 @@ int dopenwith(DFab *pFab, Datum *pDatum, ushort mode) {
 	return (pDatum == NULL) ? emsg(-1, "Datum pointer cannot be NULL") : dprep(pFab, pDatum, mode);
 	}
 
+// Open a reusable fabrication object via dprep() with given Datum object and append flag.  The object's work buffer is retained
+// by dclose() when possible, so that it does not have to be allocated again the next time the object is opened.  Return status
+// code.
+int dopenreuse(DFab *pFab, Datum *pDatum, ushort mode) {
+
+	return (pDatum == NULL) ? emsg(-1, "Datum pointer cannot be NULL") : dprep(pFab, pDatum, FabReuse | mode);
+	}
+
+// Release the work buffer retained by a reusable fabrication object that is not open and reset it to its initial state.
+void dreset(DFab *pFab) {
+
+	if(pFab->buf != NULL) {
+		free((void *) pFab->buf);
+		pFab->buf = NULL;
+		}
+	}
+
 // Return true if a fabrication object is empty, otherwise false.
 bool dfabempty(const DFab *pFab) {
 
-	return pFab->bufCur == (((pFab->flags & FabModeMask) == FabPrepend) ? pFab->bufEnd : pFab->buf) &&
-	 pFab->stack == NULL;
+	return pFab->dataBeg == pFab->dataEnd && pFab->chunks == NULL;
 	}
 
-// Convert a non-reference string datum is a string reference type.  Convert a mini-string datum to an allocated one, if
-// necessary.  Return status code.
+// Convert a non-reference string datum is a string reference type.  Convert a mini-string or shared-string datum to an
+// allocated one, if necessary.  Return status code.
 static int forceStrRef(Datum *pDatum) {
 
 	if(pDatum->type == dat_miniStr) {
 		char *str;
+		size_t len = strlen(miniStr(pDatum));
 
-		if(salloc(&str, strlen(pDatum->str) + 1, NULL) != 0)
+		if(salloc(&str, len + 1, NULL) != 0)
 			return -1;
-		strcpy(str, pDatum->str);
-		dsetstrref(str, pDatum);
+		strcpy(str, miniStr(pDatum));
+		setStrRef(str, len, pDatum, dat_longStrRef);
 		}
+	else if(pDatum->type == dat_sharedStr)
+		return drelease(pDatum);
 	else
 		pDatum->type = dat_longStrRef;
 
 	return 0;
 	}
 
-// End a fabrication object write operation and convert target Datum object to a string or byte string, according to 'type'.
-// Return status code.
+// Move the chunks in a fabrication object's chunk list into a rope, release the chunk objects, and set the rope in the
+// fabrication object's Datum object.  Return status code.
+static int ropeMake(DFab *pFab) {
+	DChunk *pChunk, *pNext;
+	DRope *pRope;
+	DMem *pPiece;
+	size_t count, size;
+
+	// Get piece count and total size.
+	count = size = 0;
+	for(pChunk = pFab->chunks; pChunk != NULL; pChunk = pChunk->next) {
+		++count;
+		size += pChunk->mem.size;
+		}
+
+	// Allocate rope.
+	if((pRope = (DRope *) malloc(sizeof(DRope) + count * sizeof(DMem))) == NULL) {
+		cxlExcep.flags |= ExcepMem;
+		return emsgsys(-1);
+		}
+	pRope->count = count;
+	pRope->size = size;
+
+	// Move chunks into it.
+	pPiece = pRope->pieces;
+	for(pChunk = pFab->chunks; pChunk != NULL; pChunk = pNext) {
+		*pPiece++ = pChunk->mem;
+		pNext = pChunk->next;
+		free((void *) pChunk);
+		}
+	pFab->chunks = NULL;
+
+	dclear(pFab->pDatum);
+	pFab->pDatum->u.pRope = pRope;
+	pFab->pDatum->type = dat_rope;
+	return 0;
+	}
+
+// Convert the contents of a single work buffer in a fabrication object (of at least ChunkSizeMax bytes) to a long string or byte
+// string in its Datum object according to 'type' without copying it, except to move it to the beginning of the buffer if
+// needed.  Return status code.
+static int fabAdopt(DFab *pFab, char *str, size_t len, bool isBinary, ushort type) {
+	char *buf;
+
+	if(str != pFab->buf)
+		str = (char *) memmove((void *) pFab->buf, (void *) str, len);
+
+	// Trim buffer to size of result (with room for a terminating null if a string).
+	if((buf = (char *) realloc((void *) str, (isBinary || type & (FabMem | FabMemRef)) ? len : len + 1)) == NULL) {
+		cxlExcep.flags |= ExcepMem;
+		return emsgsys(-1);
+		}
+	pFab->buf = NULL;
+
+	// Give buffer to Datum object.
+	if(isBinary || type & (FabMem | FabMemRef))
+		setMemRef((void *) buf, len, pFab->pDatum, type == FabMemRef ? dat_byteStrRef : dat_byteStr);
+	else {
+		buf[len] = '\0';
+		setStrRef(buf, len, pFab->pDatum, type == FabStrRef ? dat_longStrRef : dat_longStr);
+		}
+	return 0;
+	}
+
+// End a fabrication object write operation and convert target Datum object to a string, byte string, or rope, according to
+// 'type'.  Return status code.
 int dclose(DFab *pFab, ushort type) {
 
 	// Validate type.  Ensure that only one bit (or none) is set.
@@ -870,174 +1745,91 @@ TypeErr:
 			return emsgf(-1, "Unknown dclose() type, %hu", type);
 		}
 
-	// If still at starting point (no bytes written), change Datum object to empty byte string or string reference if force;
-	// otherwise, leave as a null (mini) string.
+	// If still at starting point (no bytes written), change Datum object to empty byte string, string reference, or rope if
+	// force; otherwise, leave as a null (mini) string.
 	if(dfabempty(pFab)) {
+		fabDone(pFab);
 		if(type & (FabMem | FabMemRef)) {
 			dsetmemref(NULL, 0, pFab->pDatum);
 			if(type == FabMem)
 				pFab->pDatum->type = dat_byteStr;
 			}
-		else if(type == FabStrRef && forceStrRef(pFab->pDatum) != 0)
-			return -1;
-		free((void *) pFab->buf);
+		else if(type == FabStrRef)
+			return forceStrRef(pFab->pDatum);
+		else if(type == FabRope)
+			return ropeMake(pFab);
 		}
 
-	// At least one byte was saved.  If still on first chunk, check if it contains any imbedded null bytes and save as
-	// correct type or return error as appropriate.
+	// At least one byte was saved.  If still on first chunk and a rope was not requested, check if it contains any imbedded
+	// null bytes (only if any may have been written) and save as correct type or return error as appropriate.
 	else {
-		char *str;
-		size_t len;
-
-		if((pFab->flags & FabModeMask) == FabPrepend) {
-			str = pFab->bufCur;
-			len = pFab->bufEnd - str;
-			}
-		else {
-			str = pFab->buf;
-			len = pFab->bufCur - str;
-			}
+		char *str = pFab->dataBeg;
+		size_t len = pFab->dataEnd - str;
 
-		if(pFab->stack == NULL) {
+		if(pFab->chunks == NULL && type != FabRope) {
 
 			// First chunk (and no more).  Whole string is in buffer.
-			bool isBinary = (memchr(str, '\0', len) != NULL);
+			bool isBinary = (pFab->flags & FabBinary) && memchr(str, '\0', len) != NULL;
 
 			if(isBinary && type & (FabStr | FabStrRef))
-				goto BinErr;
+				return emsg(-1, "Cannot convert binary data to string");
+			if((pFab->flags & FabSingle) && len >= ChunkSizeMax)
+				return fabAdopt(pFab, str, len, isBinary, type);
 			if(((isBinary || type & (FabMem | FabMemRef)) ? dsetmem((void *) str, len, pFab->pDatum) :
 			 dsetsubstr(str, len, pFab->pDatum)) != 0)
 				return -1;
-			free((void *) pFab->buf);
+			fabDone(pFab);
 			if(type == FabMemRef)
 				pFab->pDatum->type = dat_byteStrRef;
 			else if(type == FabStrRef && forceStrRef(pFab->pDatum) != 0)
 				return -1;
 			}
 		else {
-			// Not first chunk.  Add last one (which can't be empty) to stack and convert to a long string or byte
-			// string.  Remember pointer to work buffer in buf0 if prepending and work buffer is not full so that
-			// pointer can be passed to free() later instead of 'str'.
-			char *buf0 = (str != pFab->buf) ? pFab->buf : NULL;
-			if(fabSave(str, len, pFab) != 0)
-				return -1;
-			else {
-				DChunk *pChunk;
-				size_t size;
-				char *str0;
-				bool isBinary = false;
-				Datum *pDatum = pFab->pDatum;
-				char workBuf[sizeof(DMem)];
-
-				// Get total length.
-				len = 0;
-				pChunk = pFab->stack;
-				do {
-					len += pChunk->mem.size;
-					} while((pChunk = pChunk->next) != NULL);
-
-				// Get space for concatenated chunks.
-				if(salloc(&str, len + 1, workBuf) != 0)
+			// Not first chunk or rope requested.  Add work buffer to chunk list if not empty, then convert the chunks
+			// to a rope and concatenate them if needed.
+			if(len > 0) {
+				if(fabSave(pFab) != 0)
 					return -1;
-				str0 = str;
-
-				// Copy string pieces into it and check for any imbedded null bytes.
-				pChunk = pFab->stack;
-				if((pFab->flags & FabModeMask) == FabPrepend) {
-
-					// Prepending: copy chunks from beginning to end.
-					do {
-						size = pChunk->mem.size;
-						if(!isBinary && memchr(pChunk->mem.ptr, '\0', size) != NULL)
-							isBinary = true;
-						str = memstpcpy((void *) str, (void *) pChunk->mem.ptr, size);
-						if(buf0 != NULL) {
-							free((void *) buf0);
-							buf0 = NULL;
-							}
-						else
-							free((void *) pChunk->mem.ptr);
-						} while((pChunk = pChunk->next) != NULL);
-					*str = '\0';
-					}
-				else {
-					// Not prepending: copy chunks from end to beginning.
-					str += len + 1;
-					*--str = '\0';
-					do {
-						size = pChunk->mem.size;
-						if(!isBinary && memchr(pChunk->mem.ptr, '\0', size) != NULL)
-							isBinary = true;
-						str -= size;
-						memcpy((void *) str, (void *) pChunk->mem.ptr, size);
-						free((void *) pChunk->mem.ptr);
-						} while((pChunk = pChunk->next) != NULL);
-					}
-
-				// Set byte string in Datum object if able.
-				if(isBinary && type & (FabStr | FabStrRef))
-BinErr:
-					return emsg(-1, "Cannot convert binary data to string");
-				if(isBinary || type & (FabMem | FabMemRef)) {
-					if(str0 == workBuf) {			// "Mini" byte string in workBuf.
-						if(dsetmem((void *) workBuf, len, pDatum) != 0)
-							return -1;
-						if(type == FabMemRef)
-							pDatum->type = dat_byteStrRef;
-						}
-					else {					// Byte string in memory.
-						dsetmemref((void *) str0, len, pDatum);
-						if(type != FabMemRef)
-							pDatum->type = dat_byteStr;
-						}
-					}
-				else if(str0 == workBuf) {			// Mini-string in workBuf.
-					if(type == FabStrRef) {
-						if(salloc(&str, len + 1, NULL) != 0)
-							return -1;
-						dsetstrref(str, pDatum);
-						}
-					else {
-						dsetnull(pDatum);
-						str = pDatum->u.miniStr;
-						}
-					strcpy(str, workBuf);
-					}
-				else if(type == FabStrRef)			// Long string in memory.
-					dsetstrref(str0, pDatum);
-				else
-					dadoptstr(str0, pDatum);
 				}
+			else
+				fabDone(pFab);
+			if(ropeMake(pFab) != 0)
+				return -1;
+			if(type != FabRope)
+				return ropeFlatten(pFab->pDatum->u.pRope, pFab->pDatum, type, pFab->flags & FabBinary);
 			}
 		}
 
 	return 0;
 	}
 
-// Enable tracking on a Datum object by adding it to the garbage collection stack (if not already present).
-void dtrack(Datum *pDatum) {
+// Enable tracking on a Datum object by adding it to the garbage collection stack (if not already present).  If the object is
+// still on the stack from a prior duntrack() call, it is tracked again at its current position.  An array element cannot be
+// tracked because it is not a separately allocated object.  Return status code.
+int dtrack(Datum *pDatum) {
 
-	for(Datum *pDatum1 = datGarbHead; pDatum1 != NULL; pDatum1 = pDatum1->next)
-		if(pDatum1 == pDatum)
-			return;
-	pDatum->next = datGarbHead;
-	datGarbHead = pDatum;
+	if(pDatum->flags & DFElement)
+		return emsg(-1, "Cannot track an array element");
+	if(!(pDatum->flags & DFListed) && garbPush(dgarbctx(), pDatum) != 0)
+		return -1;
+	pDatum->flags |= DFTracked | DFListed;
+	return 0;
 	}
 
-// Stop tracking a Datum object by removing it from the garbage collection stack (if present).
+// Stop tracking a Datum object.  If it is at the top of the garbage collection stack (and no scope is using its position), it
+// is removed; otherwise, it is left on the stack in an untracked state and is removed (but not freed) when the stack is popped.
 void duntrack(Datum *pDatum) {
 
-	if(pDatum == datGarbHead) {
-		datGarbHead = datGarbHead->next;
-		pDatum->next = NULL;
+	if(pDatum->flags & DFTracked) {
+		DGarbCtx *pCtx = dgarbctx();
+
+		if(garbIsTop(pCtx, pDatum)) {
+			--pCtx->count;
+			pDatum->flags &= ~(DFTracked | DFListed);
+			}
+		else
+			pDatum->flags &= ~DFTracked;
 		}
-	else
-		for(Datum *pDatum1 = datGarbHead; pDatum1 != NULL; pDatum1 = pDatum1->next)
-			if(pDatum1->next == pDatum) {
-				pDatum1->next = pDatum->next;
-				pDatum->next = NULL;
-				break;
-				}
 	}
 
 // Copy one datum to another.  Return status code.
@@ -1049,7 +1841,6 @@ int dcpy(Datum *pDest, const Datum *pSrc) {
 		case dat_true:
 			dclear(pDest);
 			pDest->type = pSrc->type;
-			pDest->str = NULL;
 			break;
 		case dat_char:
 			dsetchr(pSrc->u.c, pDest);
@@ -1066,12 +1857,24 @@ int dcpy(Datum *pDest, const Datum *pSrc) {
 		case dat_miniStr:
 		case dat_longStr:
 		case dat_longStrRef:
-			return dsetstr(pSrc->str, pDest);
+			return setSubstr(dstr(pSrc), dstrlen(pSrc), pDest);
+		case dat_sharedStr:					// Share string (O(1))...
+			{DStr longStr = pSrc->u.longStr;
+
+			__atomic_add_fetch(&strBuf(longStr.ptr)->refCount, 1, __ATOMIC_RELAXED);
+			setStrRef(longStr.ptr, longStr.len, pDest, dat_sharedStr);	// which also works if pDest == pSrc.
+			}
+			break;
 		case dat_byteStr:
 			return dsetmem(pSrc->u.mem.ptr, pSrc->u.mem.size, pDest);
 		case dat_byteStrRef:
 			dsetmemref(pSrc->u.mem.ptr, pSrc->u.mem.size, pDest);
 			break;
+		case dat_substrRef:					// Copy reference, not substring.
+			dsetsubstrref((char *) pSrc->u.mem.ptr, pSrc->u.mem.size, pDest);
+			break;
+		case dat_rope:						// Concatenate pieces.
+			return ropeFlatten(pSrc->u.pRope, pDest, FabAuto, true);
 		case dat_array:
 			return dsetarray(pSrc->u.pArray, pDest);
 		default:	// dat_arrayRef
@@ -1080,10 +1883,89 @@ int dcpy(Datum *pDest, const Datum *pSrc) {
 	return 0;
 	}
 
+// Get the pieces of a string, byte string, substring reference, or rope in a Datum object, using given DMem object to describe a
+// string as a single piece.  Set *ppPiece to the first piece and return the number of pieces.
+static size_t dpieces(const Datum *pDatum, const DMem **ppPiece, DMem *pMem) {
+
+	if(pDatum->type == dat_rope) {
+		*ppPiece = pDatum->u.pRope->pieces;
+		return pDatum->u.pRope->count;
+		}
+	if(dtypstr(pDatum)) {
+		pMem->ptr = (void *) dstr(pDatum);
+		pMem->size = dstrlen(pDatum);
+		}
+	else
+		*pMem = pDatum->u.mem;
+	*ppPiece = pMem;
+	return 1;
+	}
+
+// Return the length in bytes of a string, byte string, substring reference, or rope in a Datum object.
+static size_t dsize(const Datum *pDatum) {
+
+	return pDatum->type == dat_rope ? pDatum->u.pRope->size : dtypstr(pDatum) ? dstrlen(pDatum) : pDatum->u.mem.size;
+	}
+
+// Compare a rope or substring reference to a string, byte string, substring reference, or rope per dflags, as if the first had
+// been converted by dflatten(), and return true if values are equal, otherwise false.  At least one of the two Datum objects must
+// be a rope or substring reference.
+static bool ropeEq(const Datum *pDatum1, const Datum *pDatum2, ushort dflags) {
+	const DMem *pPiece1, *pPieceEnd1, *pPiece2, *pPieceEnd2;
+	DMem mem, mem1;
+	size_t offset1, offset2, n;
+	bool needNull;
+	int (*cmp)(const void *str1, const void *str2, size_t len);
+
+	// Make first object the rope or substring reference and check type of second one.
+	if(!(pDatum1->type & (dat_rope | dat_substrRef))) {
+		const Datum *pDatum = pDatum1;
+		pDatum1 = pDatum2;
+		pDatum2 = pDatum;
+		}
+	if(!(pDatum2->type & (DStrMask | DMemMask | dat_rope | dat_substrRef)))
+		return false;
+
+	// A rope or substring reference is only equal to a byte string if it contains a null byte (and thus would be flattened
+	// to one), and case is never ignored in that instance.
+	needNull = dtypmem(pDatum2);
+	cmp = (dflags & DOpIgnore) && !needNull ? memcasecmp : memcmp;
+
+	// Check lengths.
+	if(dsize(pDatum1) != dsize(pDatum2))
+		return false;
+
+	// Compare pieces.
+	n = dpieces(pDatum1, &pPiece1, &mem1);
+	pPieceEnd1 = pPiece1 + n;
+	n = dpieces(pDatum2, &pPiece2, &mem);
+	pPieceEnd2 = pPiece2 + n;
+	offset1 = offset2 = 0;
+	while(pPiece1 < pPieceEnd1 && pPiece2 < pPieceEnd2) {
+		if((n = pPiece1->size - offset1) > pPiece2->size - offset2)
+			n = pPiece2->size - offset2;
+		if(cmp(pPiece1->ptr + offset1, pPiece2->ptr + offset2, n) != 0)
+			return false;
+		if(needNull && memchr(pPiece1->ptr + offset1, '\0', n) != NULL)
+			needNull = false;
+		if((offset1 += n) == pPiece1->size) {
+			++pPiece1;
+			offset1 = 0;
+			}
+		if((offset2 += n) == pPiece2->size) {
+			++pPiece2;
+			offset2 = 0;
+			}
+		}
+	return !needNull;
+	}
+
 // Compare one Datum to another per dflags and return true if values are equal, otherwise false.  If DOpIgnore flag is set,
 // ignore case in character and string comparisons.
 bool deq(const Datum *pDatum1, const Datum *pDatum2, ushort dflags) {
 
+	if((pDatum1->type | pDatum2->type) & (dat_rope | dat_substrRef))
+		return ropeEq(pDatum1, pDatum2, dflags);
 	switch(pDatum1->type) {
 		case dat_nil:
 		case dat_false:
@@ -1109,21 +1991,314 @@ bool deq(const Datum *pDatum1, const Datum *pDatum2, ushort dflags) {
 		case dat_miniStr:
 		case dat_longStr:
 		case dat_longStrRef:
+		case dat_sharedStr:
 			if(dtypstr(pDatum2)) {
-				int (*cmp)(const char *str1, const char *str2) = dflags & DOpIgnore ? strcasecmp : strcmp;
-				return cmp(pDatum1->str, pDatum2->str) == 0;
+				size_t len;
+
+				// Shared strings in the same buffer are equal, and different symbols in the same table are not.
+				if(pDatum1->type == dat_sharedStr && pDatum2->type == dat_sharedStr) {
+					if(pDatum1->u.longStr.ptr == pDatum2->u.longStr.ptr)
+						return true;
+					if(!(dflags & DOpIgnore) && sameSymTab(pDatum1->u.longStr.ptr, pDatum2->u.longStr.ptr))
+						return false;
+					}
+				len = dstrlen(pDatum1);
+
+				return len == dstrlen(pDatum2) && (dflags & DOpIgnore ?
+				 strcasecmp(dstr(pDatum1), dstr(pDatum2)) : memcmp(dstr(pDatum1), dstr(pDatum2), len)) == 0;
 				}
 			return false;
 		case dat_byteStr:
 		case dat_byteStrRef:
-			return dtypmem(pDatum2) && pDatum1->u.mem.size == pDatum2->u.mem.size &&
-			 memcmp(pDatum1->u.mem.ptr, pDatum2->u.mem.ptr, pDatum1->u.mem.size) == 0;
+			return dtypmem(pDatum2) && pDatum1->u.mem.size == pDatum2->u.mem.size && (pDatum1->u.mem.size == 0 ||
+			 memcmp(pDatum1->u.mem.ptr, pDatum2->u.mem.ptr, pDatum1->u.mem.size) == 0);
 		}
 
 	// dat_array, dat_arrayRef
 	return dtyparray(pDatum2) ? aeq(pDatum1->u.pArray, pDatum2->u.pArray, dflags & DOpIgnore) : false;
 	}
 
+// Return hash of the bytes in one or more pieces totaling "len" bytes, folding letters to lower case if "fold" is true.  The bytes
+// are hashed as if they were contiguous, in the same way as symHash(), so that the hash cached in a symbol can be used in its
+// place.
+static size_t pieceHash(const DMem *pPiece, size_t count, size_t len, bool fold) {
+	const DMem *pPieceEnd = pPiece + count;
+	uint64_t x;
+	uint64_t h = len * 0x9e3779b97f4a7c15ull;
+	uchar word[8];
+	short n = 0;
+
+	if(count == 1 && !fold && pPiece->size > 0)
+		return symHash(pPiece->ptr, pPiece->size);
+	for(; pPiece < pPieceEnd; ++pPiece) {
+		const uchar *str = pPiece->ptr;
+		const uchar *strEnd = str + pPiece->size;
+
+		while(str < strEnd) {
+			word[n] = fold ? tolower(*str) : *str;
+			++str;
+			if(++n == 8) {
+				memcpy((void *) &x, (void *) word, sizeof(x));
+				h = (h ^ x) * 0xff51afd7ed558ccdull;
+				h ^= h >> 32;
+				n = 0;
+				}
+			}
+		}
+	x = 0;
+	memcpy((void *) &x, (void *) word, n);
+	h = (h ^ x) * 0xc4ceb9fe1a85ec53ull;
+	return h ^ (h >> 29);
+	}
+
+// Return hash of a Datum object per dflags, which is consistent with deq(); that is, datums that are equal per deq() with the
+// same dflags have the same hash.  If DOpIgnore flag is set, ignore case in characters and strings.  Numbers of different types
+// that compare equal hash alike, and an array is hashed by its length and the hashes of its non-array elements only (so that
+// hashing terminates if it includes itself).
+size_t dhash(const Datum *pDatum, ushort dflags) {
+	uint64_t h;
+
+	switch(pDatum->type) {
+		case dat_nil:
+		case dat_false:
+		case dat_true:
+			h = pDatum->type;
+			break;
+		case dat_char:
+			h = (uint64_t) ((dflags & DOpIgnore) ? tolower(pDatum->u.c) : pDatum->u.c) << 16 | dat_char;
+			break;
+		case dat_int:
+		case dat_uint:
+		case dat_real:
+			{double d = pDatum->type == dat_int ? (double) pDatum->u.intNum : pDatum->type == dat_uint ?
+			 (double) pDatum->u.uintNum : pDatum->u.realNum;
+
+			// Hash numbers as reals, the type that deq() converts integers to when comparing them to reals.
+			if(d == 0.0)
+				d = 0.0;			// Fold -0.0 into 0.0.
+			memcpy((void *) &h, (void *) &d, sizeof(h));
+			}
+			break;
+		case dat_array:
+		case dat_arrayRef:
+			{const Array *pArray = pDatum->u.pArray;
+			const Datum *pArrayEl = pArray->elements;
+			const Datum *pArrayElEnd = pArrayEl + pArray->used;
+
+			h = pArray->used ^ dat_array;
+			for(; pArrayEl < pArrayElEnd; ++pArrayEl) {
+				h = (h ^ (dtyparray(pArrayEl) ? (size_t) pArrayEl->u.pArray->used : dhash(pArrayEl, dflags))) *
+				 0xff51afd7ed558ccdull;
+				h ^= h >> 32;
+				}
+			}
+			break;
+		default:	// String, byte string, substring reference, or rope.
+			{const DMem *pPiece;
+			DMem mem;
+			size_t count;
+
+			// Use hash cached in symbol if possible.
+			if(pDatum->type == dat_sharedStr && !(dflags & DOpIgnore) &&
+			 (__atomic_load_n(&strBuf(pDatum->u.longStr.ptr)->refCount, __ATOMIC_RELAXED) & StrBufSym))
+				return symBuf(pDatum->u.longStr.ptr)->hash;
+			count = dpieces(pDatum, &pPiece, &mem);
+			return pieceHash(pPiece, count, dsize(pDatum), dflags & DOpIgnore);
+			}
+		}
+
+	// Mix bits of integer result.
+	h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdull;
+	return h ^ (h >> 33);
+	}
+
+// Pair of arrays being compared by dcmp(), linked to the pair that contains them.  Self-inclusion is detected by searching this
+// list rather than by marking the arrays, since comparisons may run in several threads concurrently.
+typedef struct CmpPath {
+	const Array *pArray1, *pArray2;
+	const struct CmpPath *prev;
+	} CmpPath;
+
+// Return sort rank of a datum type for dcmp(): nil, Booleans, numbers, characters, strings, and arrays, in that order.
+static int typeRank(DatumType type) {
+
+	switch(type) {
+		case dat_nil:
+			return 0;
+		case dat_false:
+			return 1;
+		case dat_true:
+			return 2;
+		case dat_int:
+		case dat_uint:
+		case dat_real:
+			return 3;
+		case dat_char:
+			return 4;
+		case dat_array:
+		case dat_arrayRef:
+			return 6;
+		}
+	return 5;		// String, byte string, substring reference, or rope.
+	}
+
+// Compare two numeric Datum objects and return -1, 0, or 1.  Integers of either sign are compared exactly, an integer is
+// compared to a real number as a real number (as in deq()), and NaN is ordered after all other numbers.
+static int numCmp(const Datum *pDatum1, const Datum *pDatum2) {
+	double d1, d2;
+
+	if(pDatum1->type == dat_int) {
+		if(pDatum2->type == dat_int)
+			return (pDatum1->u.intNum > pDatum2->u.intNum) - (pDatum1->u.intNum < pDatum2->u.intNum);
+		if(pDatum2->type == dat_uint)
+			return pDatum1->u.intNum < 0 ? -1 : ((ulong) pDatum1->u.intNum > pDatum2->u.uintNum) -
+			 ((ulong) pDatum1->u.intNum < pDatum2->u.uintNum);
+		d1 = (double) pDatum1->u.intNum;
+		}
+	else if(pDatum1->type == dat_uint) {
+		if(pDatum2->type == dat_uint)
+			return (pDatum1->u.uintNum > pDatum2->u.uintNum) - (pDatum1->u.uintNum < pDatum2->u.uintNum);
+		if(pDatum2->type == dat_int)
+			return pDatum2->u.intNum < 0 ? 1 : (pDatum1->u.uintNum > (ulong) pDatum2->u.intNum) -
+			 (pDatum1->u.uintNum < (ulong) pDatum2->u.intNum);
+		d1 = (double) pDatum1->u.uintNum;
+		}
+	else
+		d1 = pDatum1->u.realNum;
+	d2 = pDatum2->type == dat_int ? (double) pDatum2->u.intNum : pDatum2->type == dat_uint ? (double) pDatum2->u.uintNum :
+	 pDatum2->u.realNum;
+
+	return d1 != d1 ? (d2 == d2) : d2 != d2 ? -1 : (d1 > d2) - (d1 < d2);
+	}
+
+// Return the length in bytes of a string, byte string, substring reference, or rope in a Datum object for dcmp().  Unlike
+// dsize(), an unknown string length is not cached in the object, so that concurrent comparisons by asort() never write to it.
+static size_t cmpSize(const Datum *pDatum) {
+
+	if(pDatum->type == dat_miniStr)
+		return strlen(miniStr(pDatum));
+	if(dtypstr(pDatum))
+		return pDatum->u.longStr.len != DStrLenUnk ? pDatum->u.longStr.len : strlen(pDatum->u.longStr.ptr);
+	return pDatum->type == dat_rope ? pDatum->u.pRope->size : pDatum->u.mem.size;
+	}
+
+// Get the pieces of a Datum object for dcmp() as dpieces() does, given its size from cmpSize().
+static size_t cmpPieces(const Datum *pDatum, size_t size, const DMem **ppPiece, DMem *pMem) {
+
+	if(!dtypstr(pDatum))
+		return dpieces(pDatum, ppPiece, pMem);
+	pMem->ptr = (void *) dstr(pDatum);
+	pMem->size = size;
+	*ppPiece = pMem;
+	return 1;
+	}
+
+// Compare the bytes of two strings, byte strings, substring references, or ropes lexically per dflags and return -1, 0, or 1.
+// A string that is a prefix of the other is ordered first.
+static int pieceCmp(const Datum *pDatum1, const Datum *pDatum2, ushort dflags) {
+	const DMem *pPiece1, *pPieceEnd1, *pPiece2, *pPieceEnd2;
+	DMem mem1, mem2;
+	size_t offset1, offset2, n;
+	size_t size1 = cmpSize(pDatum1);
+	size_t size2 = cmpSize(pDatum2);
+	int result;
+
+	// Compare two strings directly.
+	if(dtypstr(pDatum1) && dtypstr(pDatum2)) {
+		if((n = size1 < size2 ? size1 : size2) > 0 && (result = (dflags & DOpIgnore) ?
+		 memcasecmp(dstr(pDatum1), dstr(pDatum2), n) : memcmp(dstr(pDatum1), dstr(pDatum2), n)) != 0)
+			return result < 0 ? -1 : 1;
+		return (size1 > size2) - (size1 < size2);
+		}
+
+	// Compare pieces.
+	n = cmpPieces(pDatum1, size1, &pPiece1, &mem1);
+	pPieceEnd1 = pPiece1 + n;
+	n = cmpPieces(pDatum2, size2, &pPiece2, &mem2);
+	pPieceEnd2 = pPiece2 + n;
+	offset1 = offset2 = 0;
+	while(pPiece1 < pPieceEnd1 && pPiece2 < pPieceEnd2) {
+		if((n = pPiece1->size - offset1) > pPiece2->size - offset2)
+			n = pPiece2->size - offset2;
+		if(n > 0 && (result = (dflags & DOpIgnore) ? memcasecmp(pPiece1->ptr + offset1, pPiece2->ptr + offset2, n) :
+		 memcmp(pPiece1->ptr + offset1, pPiece2->ptr + offset2, n)) != 0)
+			return result < 0 ? -1 : 1;
+		if((offset1 += n) == pPiece1->size) {
+			++pPiece1;
+			offset1 = 0;
+			}
+		if((offset2 += n) == pPiece2->size) {
+			++pPiece2;
+			offset2 = 0;
+			}
+		}
+	return (size1 > size2) - (size1 < size2);
+	}
+
+static int datumCmp(const Datum *pDatum1, const Datum *pDatum2, ushort dflags, const CmpPath *pPath);
+
+// Compare two arrays element by element and then by length per dflags and return -1, 0, or 1.  If either array is already
+// being compared at a higher level (that is, it includes itself), the two are compared by length only so that comparison
+// terminates.
+static int arrayCmp(const Array *pArray1, const Array *pArray2, ushort dflags, const CmpPath *pPath) {
+	CmpPath path = {pArray1, pArray2, pPath};
+	const Datum *pArrayEl1 = pArray1->elements;
+	const Datum *pArrayEl2 = pArray2->elements;
+	const Datum *pArrayElEnd = pArrayEl1 + (pArray1->used < pArray2->used ? pArray1->used : pArray2->used);
+	int result;
+
+	if(pArray1 == pArray2)
+		return 0;
+	for(; pPath != NULL; pPath = pPath->prev)
+		if(pPath->pArray1 == pArray1 || pPath->pArray2 == pArray2)
+			goto Lengths;
+	for(; pArrayEl1 < pArrayElEnd; ++pArrayEl1, ++pArrayEl2)
+		if((result = datumCmp(pArrayEl1, pArrayEl2, dflags, &path)) != 0)
+			return result;
+Lengths:
+	return (pArray1->used > pArray2->used) - (pArray1->used < pArray2->used);
+	}
+
+// Compare one Datum to another per dflags for dcmp(), given the arrays that contain them (if any), and return -1, 0, or 1.
+static int datumCmp(const Datum *pDatum1, const Datum *pDatum2, ushort dflags, const CmpPath *pPath) {
+	int rank1, rank2;
+
+	// Check common case (two signed integers) first.
+	if(pDatum1->type == dat_int && pDatum2->type == dat_int)
+		return (pDatum1->u.intNum > pDatum2->u.intNum) - (pDatum1->u.intNum < pDatum2->u.intNum);
+	if((rank1 = typeRank(pDatum1->type)) != (rank2 = typeRank(pDatum2->type)))
+		return rank1 < rank2 ? -1 : 1;
+	switch(rank1) {
+		case 3:
+			return numCmp(pDatum1, pDatum2);
+		case 4:
+			{short c1 = pDatum1->u.c;
+			short c2 = pDatum2->u.c;
+			if(dflags & DOpIgnore) {
+				c1 = tolower(c1);
+				c2 = tolower(c2);
+				}
+			return (c1 > c2) - (c1 < c2);
+			}
+		case 5:
+			return pieceCmp(pDatum1, pDatum2, dflags);
+		case 6:
+			return arrayCmp(pDatum1->u.pArray, pDatum2->u.pArray, dflags, pPath);
+		}
+	return 0;		// nil, false, or true.
+	}
+
+// Compare one Datum to another per dflags and return -1 (first is less), 0 (equal), or 1 (first is greater).  Values of
+// different kinds are ordered nil, false, true, numbers, characters, strings, and arrays.  Numbers of any type are compared
+// numerically, characters by value, and strings, byte strings, substring references, and ropes lexically by byte.  Arrays are
+// compared element by element (recursively) and then by length, except that an array that includes itself is compared by length
+// where it recurs.  If DOpIgnore flag is set, ignore case in characters and strings.  The Datum objects are not modified, so
+// this function may be called on the same objects from several threads concurrently.
+int dcmp(const Datum *pDatum1, const Datum *pDatum2, ushort dflags) {
+
+	return datumCmp(pDatum1, pDatum2, dflags, NULL);
+	}
+
 // Copy string from 'str' to 'pDatum', adding a single quote (') at beginning and end and converting single quote characters
 // to '\''.  Return status.
 int dshquote(const char *str, Datum *pDatum) {
@@ -1170,21 +2345,23 @@ int dtos(Datum *pDest, const Datum *pSrc, const char *delim, ushort cflags) {
 	char *str;
 	DFab fab;
 	int rtnCode = 0;
+	char workBuf[NumBufSize];
 
 	// Do simple conversion if possible.
-	switch(dtos1(&str, pSrc, cflags)) {
+	switch(dtos1(&str, pSrc, cflags, workBuf)) {
 		case -1:	// Error.
 			return -1;
 		case 0:		// Keyword or simple string.
-			return dsetstr(str, pDest);
+			return dtypstr(pSrc) ? dcpy(pDest, pSrc) : dsetstr(str, pDest);
 		}
 
 	// Have character, string, byte string, or array needing conversion.  Open fabrication object and call appropriate
 	// routine.
 	return dopenwith(&fab, pDest, FabClear) != 0 ||
 	 (dischr(pSrc) ? dputc(pSrc->u.c, &fab, cflags) :
-	 dtypstr(pSrc) ? dputs(pSrc->str, &fab, cflags) :
-	 dtypmem(pSrc) ? qput(pSrc->u.mem.ptr, pSrc->u.mem.ptr + pSrc->u.mem.size, &fab, cflags) :
+	 dtypstr(pSrc) ? qput(dstr(pSrc), dstr(pSrc) + dstrlen(pSrc), &fab, cflags) :
+	 pSrc->type & (DMemMask | dat_substrRef) ? qput(pSrc->u.mem.ptr, pSrc->u.mem.ptr + pSrc->u.mem.size, &fab, cflags) :
+	 pSrc->type == dat_rope ? ropePut(pSrc->u.pRope, &fab, cflags) :
 	 (rtnCode = aput(pSrc->u.pArray, &fab, delim, cflags))) < 0 ||
 	 dclose(&fab, FabStr) != 0 ? -1 : rtnCode;
 	}
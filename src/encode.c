@@ -0,0 +1,347 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// encode.c		Routines for encoding Datum objects in a compact binary form and decoding them.
+//
+// Encoding format: each datum is stored as a one-byte type tag, followed by its value (if any):
+//	EncNil, EncFalse, EncTrue	No value.
+//	EncChar, EncInt			Zigzag-encoded varint (so that small negative numbers are short).
+//	EncUInt				Varint.
+//	EncReal				Eight-byte IEEE 754 double, least significant byte first.
+//	EncStr				Varint length, string, and terminating null (so that a decoded string can reference
+//					the encoded data).
+//	EncMem				Varint length and bytes.
+//	EncArray			Varint element count, followed by the encoded elements.
+// A varint holds an unsigned integer in seven-bit groups, least significant group first, one group per byte, with the high bit
+// set in all bytes but the last.
+
+#include "stdos.h"
+#include "cxl/excep.h"
+#include "cxl/datum.h"
+#include "cxl/array.h"
+#include "cxl/fastio.h"
+#include "cxl/lib.h"
+#include <string.h>
+
+// Type tags.
+#define EncNil		0			// Nil value.
+#define EncFalse	1			// False value.
+#define EncTrue		2			// True value.
+#define EncChar		3			// Character.
+#define EncInt		4			// Signed integer.
+#define EncUInt		5			// Unsigned integer.
+#define EncReal		6			// Real number.
+#define EncStr		7			// String.
+#define EncMem		8			// Byte string.
+#define EncArray	9			// Array.
+
+#define VarintMax	10			// Maximum size of a 64-bit varint.
+#define EncNestMax	1000			// Maximum array nesting depth when encoding or decoding.
+
+// Destination for encoded data: a fabrication object or a fast file.
+typedef struct {
+	DFab *pFab;				// Fabrication object, or NULL if writing to a file.
+	FastFile *pFastFile;			// Fast file.
+	} EncSink;
+
+// Source of encoded data.
+typedef struct {
+	const uchar *cur;			// Next byte to decode.
+	const uchar *end;			// End of encoded data.
+	ushort flags;				// Decoding flags.
+	} DecSource;
+
+// Thread-local variables.
+static __thread uint32_t encodeID = 0;		// Random ID number used to detect if an array contains itself.
+
+// Write bytes to an encoding destination.  Return status code.
+static int encPut(const void *ptr, size_t len, EncSink *pSink) {
+
+	if(len == 0)
+		return 0;
+	return pSink->pFab != NULL ? dputmem(ptr, len, pSink->pFab, 0) : ffwrite((void *) ptr, len, pSink->pFastFile);
+	}
+
+// Store a type tag and an unsigned varint in buf and return pointer to the byte following them.
+static uchar *encHead(uchar *buf, uchar tag, uint64_t u) {
+
+	*buf++ = tag;
+	while(u >= 0x80) {
+		*buf++ = (u & 0x7F) | 0x80;
+		u >>= 7;
+		}
+	*buf++ = u;
+	return buf;
+	}
+
+// Return a signed integer in zigzag form (0, -1, 1, -2, 2, ... are mapped to 0, 1, 2, 3, 4, ...).
+static uint64_t zigzag(long i) {
+
+	return ((uint64_t) i << 1) ^ (uint64_t) (i < 0 ? -1 : 0);
+	}
+
+// Encode a datum and write it to given destination.  Arrays are encoded recursively.  Return status code.
+static int encode(const Datum *pDatum, EncSink *pSink, uint depth) {
+	uchar *bufEnd;
+	uchar buf[1 + VarintMax];
+
+	switch(pDatum->type) {
+		case dat_nil:
+			*(bufEnd = buf) = EncNil;
+			++bufEnd;
+			break;
+		case dat_false:
+		case dat_true:
+			*(bufEnd = buf) = (pDatum->type == dat_true) ? EncTrue : EncFalse;
+			++bufEnd;
+			break;
+		case dat_char:
+			bufEnd = encHead(buf, EncChar, zigzag(pDatum->u.c));
+			break;
+		case dat_int:
+			bufEnd = encHead(buf, EncInt, zigzag(pDatum->u.intNum));
+			break;
+		case dat_uint:
+			bufEnd = encHead(buf, EncUInt, pDatum->u.uintNum);
+			break;
+		case dat_real:
+			{uint64_t bits;
+
+			memcpy((void *) &bits, (void *) &pDatum->u.realNum, sizeof(bits));
+			*(bufEnd = buf) = EncReal;
+			do {
+				*++bufEnd = bits;
+				bits >>= 8;
+				} while(bufEnd < buf + 8);
+			++bufEnd;
+			}
+			break;
+		case dat_byteStr:
+		case dat_byteStrRef:
+			return encPut((void *) buf, encHead(buf, EncMem, pDatum->u.mem.size) - buf, pSink) != 0 ||
+			 encPut(pDatum->u.mem.ptr, pDatum->u.mem.size, pSink) != 0 ? -1 : 0;
+		case dat_substrRef:	// Encode as a string (with terminating null added), or a byte string if it contains a null byte.
+			{DMem mem = pDatum->u.mem;
+			uchar tag = memchr(mem.ptr, '\0', mem.size) != NULL ? EncMem : EncStr;
+
+			return encPut((void *) buf, encHead(buf, tag, mem.size) - buf, pSink) != 0 ||
+			 encPut(mem.ptr, mem.size, pSink) != 0 || (tag == EncStr && encPut((void *) "", 1, pSink) != 0) ? -1 : 0;
+			}
+		case dat_array:
+		case dat_arrayRef:
+			{Array *pArray = pDatum->u.pArray;
+			Datum *pArrayEl = pArray->elements;
+			Datum *pArrayElEnd = pArrayEl + pArray->used;
+
+			// Mark the array while its elements are being encoded.  If the mark is found on an array, it contains
+			// itself (directly or via a nested array), which can't be encoded.
+			if(pArray->id == encodeID)
+				return emsg(-1, "Cannot encode array that contains itself");
+			if(depth == EncNestMax)
+				return emsgf(-1, "Arrays nested too deeply (maximum %d) to encode", EncNestMax);
+			if(encPut((void *) buf, encHead(buf, EncArray, pArray->used) - buf, pSink) != 0)
+				return -1;
+			pArray->id = encodeID;
+			while(pArrayEl < pArrayElEnd)
+				if(encode(pArrayEl++, pSink, depth + 1) != 0) {
+					pArray->id = 0;
+					return -1;
+					}
+			pArray->id = 0;
+			}
+			return 0;
+		case dat_rope:
+			{const DRope *pRope = pDatum->u.pRope;
+			const DMem *pPiece;
+			const DMem *pPieceEnd = pRope->pieces + pRope->count;
+			uchar tag = EncStr;
+
+			// Encode as a byte string if rope contains a null byte, otherwise as a string.
+			for(pPiece = pRope->pieces; pPiece < pPieceEnd; ++pPiece)
+				if(memchr(pPiece->ptr, '\0', pPiece->size) != NULL) {
+					tag = EncMem;
+					break;
+					}
+			if(encPut((void *) buf, encHead(buf, tag, pRope->size) - buf, pSink) != 0)
+				return -1;
+			for(pPiece = pRope->pieces; pPiece < pPieceEnd; ++pPiece)
+				if(encPut(pPiece->ptr, pPiece->size, pSink) != 0)
+					return -1;
+			return tag == EncStr ? encPut((void *) "", 1, pSink) : 0;
+			}
+		default:	// String.
+			{const char *str = dstr(pDatum);
+			size_t len = dstrlen(pDatum);
+
+			return encPut((void *) buf, encHead(buf, EncStr, len) - buf, pSink) != 0 ||
+			 encPut((void *) str, len + 1, pSink) != 0 ? -1 : 0;
+			}
+		}
+
+	return encPut((void *) buf, bufEnd - buf, pSink);
+	}
+
+// Prepare for encoding: generate new array ID.
+static void encInit(void) {
+
+	encodeID = rand32Uniform(UINT32_MAX - 1) + 1;	// Will never be zero.
+	}
+
+// Encode a datum in binary form and write it to a fabrication object.  Return status code.
+int dencode(const Datum *pDatum, DFab *pFab) {
+	EncSink sink = {pFab, NULL};
+
+	// If prepending, encode datum in a temporary fabrication object (from left to right) and prepend the result.
+	if((pFab->flags & FabModeMask) == FabPrepend) {
+		DFab fab, *pTempFab;
+
+		return (pTempFab = bopentemp(&fab)) == NULL ? -1 : bputfab(pTempFab, pFab, dencode(pDatum, pTempFab));
+		}
+
+	encInit();
+	return encode(pDatum, &sink, 0);
+	}
+
+// Encode a datum in binary form and write it to a data file.  Return status code.
+int ffencode(const Datum *pDatum, FastFile *pFastFile) {
+	EncSink sink = {NULL, pFastFile};
+
+	encInit();
+	return encode(pDatum, &sink, 0);
+	}
+
+// Set "unexpected end of data" error and return -1.
+static int decEnd(void) {
+
+	return emsg(-1, "Unexpected end of encoded data");
+	}
+
+// Decode a varint and store it in *pVal.  Return status code.
+static int decVarint(DecSource *pSrc, uint64_t *pVal) {
+	uint64_t u = 0;
+	int shift = 0;
+	uchar b;
+
+	do {
+		if(pSrc->cur == pSrc->end)
+			return decEnd();
+		b = *pSrc->cur++;
+		if(shift == 63 && b > 1)
+			return emsg(-1, "Invalid varint in encoded data");
+		u |= (uint64_t) (b & 0x7F) << shift;
+		shift += 7;
+		} while((b & 0x80) && shift <= 63);
+	if(b & 0x80)
+		return emsg(-1, "Invalid varint in encoded data");
+	*pVal = u;
+	return 0;
+	}
+
+// Decode a datum and save it in *pDatum.  Arrays are decoded recursively.  Return status code.
+static int decode(Datum *pDatum, DecSource *pSrc, uint depth) {
+	uint64_t u = 0;
+	uchar tag;
+
+	if(pSrc->cur == pSrc->end)
+		return decEnd();
+	tag = *pSrc->cur++;
+	if(tag > EncArray)
+		return emsgf(-1, "Invalid type (%hu) in encoded data", (ushort) tag);
+
+	// Get varint value or length, if applicable.
+	if(tag != EncNil && tag != EncFalse && tag != EncTrue && tag != EncReal && decVarint(pSrc, &u) != 0)
+		return -1;
+
+	switch(tag) {
+		case EncNil:
+			dclear(pDatum);
+			break;
+		case EncFalse:
+		case EncTrue:
+			dsetbool(tag == EncTrue, pDatum);
+			break;
+		case EncChar:
+			dsetchr((short) ((u >> 1) ^ -(u & 1)), pDatum);
+			break;
+		case EncInt:
+			dsetint((long) ((u >> 1) ^ -(u & 1)), pDatum);
+			break;
+		case EncUInt:
+			dsetuint(u, pDatum);
+			break;
+		case EncReal:
+			{const uchar *src;
+			double r;
+
+			if(pSrc->end - pSrc->cur < 8)
+				return decEnd();
+			src = (pSrc->cur += 8);
+			do {
+				u = (u << 8) | *--src;
+				} while(src > pSrc->cur - 8);
+			memcpy((void *) &r, (void *) &u, sizeof(r));
+			dsetreal(r, pDatum);
+			}
+			break;
+		case EncStr:
+			if((uint64_t) (pSrc->end - pSrc->cur) <= u)
+				return decEnd();
+			if(pSrc->cur[u] != '\0')
+				return emsg(-1, "Unterminated string in encoded data");
+			if(memchr((void *) pSrc->cur, '\0', u) != NULL)
+				return emsg(-1, "Null byte in string in encoded data");
+			if(pSrc->flags & DDecRef) {
+				dsetstrref((char *) pSrc->cur, pDatum);
+				pDatum->u.longStr.len = u;		// Length is known, so don't scan for it later.
+				}
+			else if(dsetsubstr((const char *) pSrc->cur, u, pDatum) != 0)
+				return -1;
+			pSrc->cur += u + 1;
+			break;
+		case EncMem:
+			if((uint64_t) (pSrc->end - pSrc->cur) < u)
+				return decEnd();
+			if(pSrc->flags & DDecRef)
+				dsetmemref((void *) pSrc->cur, u, pDatum);
+			else if(dsetmem((void *) pSrc->cur, u, pDatum) != 0)
+				return -1;
+			pSrc->cur += u;
+			break;
+		default:	// Array.
+			{Array *pArray;
+			Datum *pArrayEl, *pArrayElEnd;
+
+			// Each element takes at least one byte, so the element count can be checked before the array is created.
+			if((uint64_t) (pSrc->end - pSrc->cur) < u)
+				return decEnd();
+			if(depth == EncNestMax)
+				return emsgf(-1, "Arrays nested too deeply (maximum %d) in encoded data", EncNestMax);
+			if((pArray = anew(u, NULL)) == NULL)
+				return -1;
+			pArrayElEnd = (pArrayEl = pArray->elements) + u;
+			while(pArrayEl < pArrayElEnd)
+				if(decode(pArrayEl++, pSrc, depth + 1) != 0) {
+					afree(pArray);
+					return -1;
+					}
+			dadoptarray(pArray, pDatum);
+			}
+		}
+
+	return 0;
+	}
+
+// Decode a datum from size bytes of encoded data in buf and save it in *pDatum.  If the DDecRef flag is set, strings and byte
+// strings in the result reference the encoded data instead of being copied, so buf must remain intact while they are in use.
+// Return the number of bytes decoded (so that a sequence of encoded datums can be decoded in a loop), or -1 if error.
+ssize_t ddecode(Datum *pDatum, const void *buf, size_t size, ushort flags) {
+	DecSource src = {(const uchar *) buf, (const uchar *) buf + size, flags};
+
+	if(decode(pDatum, &src, 0) != 0) {
+		dclear(pDatum);
+		return -1;
+		}
+	return src.cur - (const uchar *) buf;
+	}
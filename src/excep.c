@@ -15,8 +15,8 @@
 
 #define	ExcepExitCode	-1		// excep() function return Value if exit() not called.
 
-// Global variables.
-CXLExcep cxlExcep = {0, 0, NULL};
+// Thread-local variables.
+__thread CXLExcep cxlExcep = {0, 0, NULL};
 
 // Free exception message allocated from heap, if applicable.
 static void freeMsg(void) {
@@ -8,11 +8,13 @@
 #include "stdos.h"
 #include "cxl/excep.h"
 #include "cxl/string.h"
+#include "cxl/datum.h"
 #include "cxl/fastio.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <errno.h>
 
@@ -20,6 +22,7 @@
 #define FileBufSize		65536		// Buffer size for all other files.
 #define LineBufSize		256		// Initial line buffer size.
 #define LineBufMult		4		// Multiplier for growing line buffer when full.
+#define IOVecMax		64		// Maximum number of rope pieces to pass to writev() at once.
 
 // Return number of unread data bytes in file buffer.  If empty, read more.  If an error occurs, return -1.
 static ssize_t fileBufSize(FastFile *pFastFile) {
@@ -478,6 +481,52 @@ int ffwrite(void *buf, size_t len, FastFile *pFastFile) {
 	return 0;
 	}
 
+// Write the pieces of a rope (type dat_rope) to a data file.  If the rope fits in the space left in the file buffer, it is copied
+// there; otherwise, the buffer is flushed and the pieces are written directly from memory via writev() calls.  Return status
+// code.
+int ffwriterope(const DRope *pRope, FastFile *pFastFile) {
+	struct iovec iov[IOVecMax], *pIOVec;
+	const DMem *pPiece = pRope->pieces;
+	const DMem *pPieceEnd = pPiece + pRope->count;
+	ssize_t bytesWritten;
+	int count;
+
+	// Small rope?
+	if(pRope->size <= (size_t) (pFastFile->dataBufEnd - pFastFile->dataBufCur)) {
+		for(; pPiece < pPieceEnd; ++pPiece)
+			pFastFile->dataBufCur = (char *) memstpcpy((void *) pFastFile->dataBufCur, pPiece->ptr, pPiece->size);
+		return 0;
+		}
+
+	// Nope.  Flush buffer and write pieces in batches.
+	if(ffflush(pFastFile) != 0)
+		return -1;
+	while(pPiece < pPieceEnd) {
+		for(count = 0; count < IOVecMax && pPiece < pPieceEnd; ++count, ++pPiece) {
+			iov[count].iov_base = pPiece->ptr;
+			iov[count].iov_len = pPiece->size;
+			}
+
+		// Write batch, resuming after a short write.
+		pIOVec = iov;
+		for(;;) {
+			if((bytesWritten = writev(pFastFile->fileHandle, pIOVec, count)) == -1)
+				return emsgf(-1, "%s, writing %lu bytes to file '%s'", strerror(errno), pRope->size,
+				 pFastFile->filename);
+			while(count > 0 && (size_t) bytesWritten >= pIOVec->iov_len) {
+				bytesWritten -= pIOVec->iov_len;
+				++pIOVec;
+				--count;
+				}
+			if(count == 0)
+				break;
+			pIOVec->iov_base += bytesWritten;
+			pIOVec->iov_len -= bytesWritten;
+			}
+		}
+	return 0;
+	}
+
 // Write a null-terminated string to a data file.  Return status code.
 int ffputs(const char *str, FastFile *pFastFile) {
 
@@ -503,18 +552,51 @@ int ffputvizmem(const void *memPtr, size_t size, ushort flags, FastFile *pFastFi
 	return 0;
 	}
 
-// Write a formatted string to a data file.  Return status code.
+// Write a formatted string to a data file.  The string is formatted directly into the file buffer, which is flushed first if
+// the string does not fit in the free space.  If it is larger than the whole buffer, it is formatted into a heap buffer and
+// written from there instead.  Return status code.
 int ffprintf(FastFile *pFastFile, const char *fmt, ...) {
-	int rtnCode;
+	int len, rtnCode;
 	char *result;
-	va_list varArgList;
+	va_list varArgList, varArgList1;
 
+	// Format string into free space in file buffer.
 	va_start(varArgList, fmt);
-	rtnCode = vasprintf(&result, fmt, varArgList);
+	va_copy(varArgList1, varArgList);
+	len = vsnprintf(pFastFile->dataBufCur, pFastFile->dataBufEnd - pFastFile->dataBufCur, fmt, varArgList1);
+	va_end(varArgList1);
+
+	// String didn't fit?
+	if(len >= 0 && len >= pFastFile->dataBufEnd - pFastFile->dataBufCur) {
+
+		// Yes.  Flush buffer and format it again if it will fit now...
+		if((size_t) len < pFastFile->dataBufSize) {
+			if(ffflush(pFastFile) != 0) {
+				va_end(varArgList);
+				return -1;
+				}
+			len = vsnprintf(pFastFile->dataBufCur, pFastFile->dataBufSize, fmt, varArgList);
+			}
+
+		// otherwise, format it into a heap buffer and write it from there.
+		else {
+			if((result = (char *) malloc(len + 1)) == NULL) {
+				va_end(varArgList);
+				cxlExcep.flags |= ExcepMem;
+				return emsgsys(-1);
+				}
+			(void) vsnprintf(result, len + 1, fmt, varArgList);
+			va_end(varArgList);
+			rtnCode = ffputs(result, pFastFile);
+			free((void *) result);
+			return rtnCode;
+			}
+		}
 	va_end(varArgList);
-	if(rtnCode < 0)
+	if(len < 0)
 		return emsgsys(-1);
-	rtnCode = ffputs(result, pFastFile);
-	free((void *) result);
-	return rtnCode;
+
+	// String is in file buffer.  Advance past it, stopping at any null byte (as ffputs() does).
+	pFastFile->dataBufCur += strlen(pFastFile->dataBufCur);
+	return 0;
 	}
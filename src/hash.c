@@ -121,7 +121,7 @@ Retn:
 // to the Hash object and is modified by this routine.
 HashRec *heach(HashTable **pHashTable) {
 	HashRec *pHashRec;
-	static struct {
+	static __thread struct {
 		HashRec **ppHashRec, **ppHashRecEnd, *pHashRec;
 		} hashState = {
 			NULL, NULL, NULL
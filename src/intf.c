@@ -8,7 +8,7 @@
 #include "stdos.h"
 #include <stdbool.h>
 
-static char result[sizeof(ulong) * 4];
+static __thread char result[sizeof(ulong) * 4];
 
 // Convert given long integer to a string (allocated in static storage) with a leading sign if "neg" is true, and commas every
 // three digits.  Return result.
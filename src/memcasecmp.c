@@ -9,18 +9,18 @@
 
 #define lowCase(c)	((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c)
 
-// Compare two byte strings, folding upper-case letters to lower case.  Return an integer less than zero (str1 < str2),
-// zero (str1 == str2), or greater than zero (str1 > str2).
+// Compare two byte strings, folding upper-case letters to lower case.  Return -1 (str1 < str2), zero (str1 == str2), or 1
+// (str1 > str2).
 int memcasecmp(const void *str1, const void *str2, size_t len) {
 	short c1, c2;
-	char *memStr1 = (char *) str1;
-	char *memStr2 = (char *) str2;
+	unsigned char *memStr1 = (unsigned char *) str1;
+	unsigned char *memStr2 = (unsigned char *) str2;
 
-	for(c1 = c2 = 0; len > 0; --len) {
+	for(; len > 0; --len) {
 		c1 = *memStr1++;
 		c2 = *memStr2++;
-		if(lowCase(c1) != lowCase(c2))
-			break;
+		if((c1 = lowCase(c1)) != (c2 = lowCase(c2)))
+			return c1 < c2 ? -1 : 1;
 		}
-	return c1 - c2;
+	return 0;
 	}
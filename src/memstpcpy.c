@@ -6,13 +6,10 @@
 // memstpcpy.c		Routine for copying bytes in memory, returning pointer to where copying "stopped".
 
 #include <stddef.h>
+#include <string.h>
 
 // Copy "len" bytes from "src" to "dest".  Return pointer in dest to byte after last byte copied.
 void *memstpcpy(void *dest, const void *src, size_t len) {
-	char *dest1 = (char *) dest;
-	char *src1 = (char *) src;
 
-	while(len--)
-		*dest1++ = *src1++;
-	return (void *) dest1;
+	return (void *) ((char *) memcpy(dest, src, len) + len);
 	}
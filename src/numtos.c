@@ -0,0 +1,310 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// numtos.c		Routines for converting an integer or real number to a string quickly.
+
+#include "stdos.h"
+#include "cxl/lib.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DblSignBit	0x8000000000000000ull	// Sign bit of a double.
+#define DblHiddenBit	0x0010000000000000ull	// Implicit leading significand bit of a normal double.
+#define DblSigMask	0x000FFFFFFFFFFFFFull	// Significand bits of a double.
+#define DblExpBias	1075			// Exponent bias of a double, plus significand size (52).
+#define FixedMax	16			// Use exponential form if decimal exponent is at least this...
+#define FixedMin	-4			// or less than this.
+
+// Floating point number with a 64-bit significand and a binary exponent (value is f * 2^e), used by realtos().
+typedef struct {
+	uint64_t f;
+	int e;
+	} DiyFp;
+
+// Digit pairs "00" through "99", for converting an integer two digits at a time.
+static const char digitPairs[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+// Powers of ten from 1 to 10^19.
+static const uint64_t pow10[] = {1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+	1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+	1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull};
+
+// Cached powers of ten from 10^-348 to 10^340 in steps of 8, as normalized DiyFp values.
+static const DiyFp cachedPowers[] = {
+	{0xfa8fd5a0081c0288ull, -1220}, {0xbaaee17fa23ebf76ull, -1193}, {0x8b16fb203055ac76ull, -1166}, {0xcf42894a5dce35eaull, -1140},
+	{0x9a6bb0aa55653b2dull, -1113}, {0xe61acf033d1a45dfull, -1087}, {0xab70fe17c79ac6caull, -1060}, {0xff77b1fcbebcdc4full, -1034},
+	{0xbe5691ef416bd60cull, -1007}, {0x8dd01fad907ffc3cull, -980}, {0xd3515c2831559a83ull, -954}, {0x9d71ac8fada6c9b5ull, -927},
+	{0xea9c227723ee8bcbull, -901}, {0xaecc49914078536dull, -874}, {0x823c12795db6ce57ull, -847}, {0xc21094364dfb5637ull, -821},
+	{0x9096ea6f3848984full, -794}, {0xd77485cb25823ac7ull, -768}, {0xa086cfcd97bf97f4ull, -741}, {0xef340a98172aace5ull, -715},
+	{0xb23867fb2a35b28eull, -688}, {0x84c8d4dfd2c63f3bull, -661}, {0xc5dd44271ad3cdbaull, -635}, {0x936b9fcebb25c996ull, -608},
+	{0xdbac6c247d62a584ull, -582}, {0xa3ab66580d5fdaf6ull, -555}, {0xf3e2f893dec3f126ull, -529}, {0xb5b5ada8aaff80b8ull, -502},
+	{0x87625f056c7c4a8bull, -475}, {0xc9bcff6034c13053ull, -449}, {0x964e858c91ba2655ull, -422}, {0xdff9772470297ebdull, -396},
+	{0xa6dfbd9fb8e5b88full, -369}, {0xf8a95fcf88747d94ull, -343}, {0xb94470938fa89bcfull, -316}, {0x8a08f0f8bf0f156bull, -289},
+	{0xcdb02555653131b6ull, -263}, {0x993fe2c6d07b7facull, -236}, {0xe45c10c42a2b3b06ull, -210}, {0xaa242499697392d3ull, -183},
+	{0xfd87b5f28300ca0eull, -157}, {0xbce5086492111aebull, -130}, {0x8cbccc096f5088ccull, -103}, {0xd1b71758e219652cull, -77},
+	{0x9c40000000000000ull, -50}, {0xe8d4a51000000000ull, -24}, {0xad78ebc5ac620000ull, 3}, {0x813f3978f8940984ull, 30},
+	{0xc097ce7bc90715b3ull, 56}, {0x8f7e32ce7bea5c70ull, 83}, {0xd5d238a4abe98068ull, 109}, {0x9f4f2726179a2245ull, 136},
+	{0xed63a231d4c4fb27ull, 162}, {0xb0de65388cc8ada8ull, 189}, {0x83c7088e1aab65dbull, 216}, {0xc45d1df942711d9aull, 242},
+	{0x924d692ca61be758ull, 269}, {0xda01ee641a708deaull, 295}, {0xa26da3999aef774aull, 322}, {0xf209787bb47d6b85ull, 348},
+	{0xb454e4a179dd1877ull, 375}, {0x865b86925b9bc5c2ull, 402}, {0xc83553c5c8965d3dull, 428}, {0x952ab45cfa97a0b3ull, 455},
+	{0xde469fbd99a05fe3ull, 481}, {0xa59bc234db398c25ull, 508}, {0xf6c69a72a3989f5cull, 534}, {0xb7dcbf5354e9beceull, 561},
+	{0x88fcf317f22241e2ull, 588}, {0xcc20ce9bd35c78a5ull, 614}, {0x98165af37b2153dfull, 641}, {0xe2a0b5dc971f303aull, 667},
+	{0xa8d9d1535ce3b396ull, 694}, {0xfb9b7cd9a4a7443cull, 720}, {0xbb764c4ca7a44410ull, 747}, {0x8bab8eefb6409c1aull, 774},
+	{0xd01fef10a657842cull, 800}, {0x9b10a4e5e9913129ull, 827}, {0xe7109bfba19c0c9dull, 853}, {0xac2820d9623bf429ull, 880},
+	{0x80444b5e7aa7cf85ull, 907}, {0xbf21e44003acdd2dull, 933}, {0x8e679c2f5e44ff8full, 960}, {0xd433179d9c8cb841ull, 986},
+	{0x9e19db92b4e31ba9ull, 1013}, {0xeb96bf6ebadf77d9ull, 1039}, {0xaf87023b9bf0ee6bull, 1066},
+	};
+
+// Convert given unsigned long integer to a string in dest, which must be at least NumBufSize bytes in size.  Return pointer
+// to terminating null byte.
+char *uinttos(ulong i, char *dest) {
+	char workBuf[24];
+	char *str = workBuf + sizeof(workBuf);
+	const char *pair;
+	size_t len;
+
+	// Convert two digits at a time from right to left...
+	while(i >= 100) {
+		pair = digitPairs + (i % 100) * 2;
+		i /= 100;
+		*--str = pair[1];
+		*--str = pair[0];
+		}
+	if(i >= 10) {
+		pair = digitPairs + i * 2;
+		*--str = pair[1];
+		*--str = pair[0];
+		}
+	else
+		*--str = '0' + i;
+
+	// and copy result to caller's buffer.
+	len = workBuf + sizeof(workBuf) - str;
+	memcpy((void *) dest, (void *) str, len);
+	dest[len] = '\0';
+	return dest + len;
+	}
+
+// Convert given long integer to a string in dest with a leading minus sign if negative.  dest must be at least NumBufSize
+// bytes in size.  Return pointer to terminating null byte.
+char *inttos(long i, char *dest) {
+
+	if(i < 0) {
+		*dest++ = '-';
+		return uinttos(-(ulong) i, dest);
+		}
+	return uinttos(i, dest);
+	}
+
+// Return product of two DiyFp values, rounded to 64 bits.
+static DiyFp diyMult(DiyFp x, DiyFp y) {
+	DiyFp result;
+	uint64_t a = x.f >> 32, b = x.f & 0xFFFFFFFF, c = y.f >> 32, d = y.f & 0xFFFFFFFF;
+	uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	uint64_t mid = (bd >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + (1u << 31);
+
+	result.f = ac + (ad >> 32) + (bc >> 32) + (mid >> 32);
+	result.e = x.e + y.e + 64;
+	return result;
+	}
+
+// Shift a DiyFp value left so that the most significant bit of its significand is set.
+static DiyFp diyNormalize(DiyFp x) {
+	int shift = __builtin_clzll(x.f);
+
+	x.f <<= shift;
+	x.e -= shift;
+	return x;
+	}
+
+// Move the last digit in buf down (toward w) while the result is still in the rounding interval and closer to w.
+static void grisuRound(char *buf, int len, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t wpw) {
+
+	while(rest < wpw && delta - rest >= tenKappa &&
+	 (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw)) {
+		--buf[len - 1];
+		rest += tenKappa;
+		}
+	}
+
+// Generate the digits of w, given its upper boundary wp and the width of the rounding interval delta (all scaled by a cached
+// power of ten).  Store digits in buf, set *pLen to the digit count, and adjust the decimal exponent in *pK.
+static void grisuDigits(DiyFp w, DiyFp wp, uint64_t delta, char *buf, int *pLen, int *pK) {
+	int shift = -wp.e;
+	uint64_t one = (uint64_t) 1 << shift;
+	uint64_t wpw = wp.f - w.f;
+	uint32_t p1 = wp.f >> shift;
+	uint64_t p2 = wp.f & (one - 1);
+	uint64_t rest;
+	int kappa, len = 0;
+	uint d;
+
+	// Get number of digits in integral part.
+	for(kappa = 1; kappa < 10 && p1 >= pow10[kappa]; ++kappa);
+
+	// Generate digits of integral part.
+	while(kappa > 0) {
+		d = p1 / (uint32_t) pow10[kappa - 1];
+		p1 %= (uint32_t) pow10[kappa - 1];
+		if(d != 0 || len != 0)
+			buf[len++] = '0' + d;
+		--kappa;
+		if((rest = ((uint64_t) p1 << shift) + p2) <= delta) {
+			*pK += kappa;
+			grisuRound(buf, len, delta, rest, pow10[kappa] << shift, wpw);
+			goto Retn;
+			}
+		}
+
+	// Generate digits of fractional part.
+	for(;;) {
+		p2 *= 10;
+		delta *= 10;
+		d = p2 >> shift;
+		if(d != 0 || len != 0)
+			buf[len++] = '0' + d;
+		p2 &= one - 1;
+		--kappa;
+		if(p2 < delta) {
+			*pK += kappa;
+			grisuRound(buf, len, delta, p2, one, -kappa < 20 ? wpw * pow10[-kappa] : 0);
+			break;
+			}
+		}
+Retn:
+	*pLen = len;
+	}
+
+// Convert a positive, finite double (given as its bit pattern) to a short string of decimal digits that converts back to the
+// same value, using the Grisu2 algorithm.  The string is not always the shortest: for about 0.1% of values, Grisu2 produces
+// one or more extra digits.  Store digits (not null terminated) in buf, set *pLen to the digit count, and set *pK to the
+// decimal exponent (value is digits * 10^K).
+static void grisu2(uint64_t bits, char *buf, int *pLen, int *pK) {
+	DiyFp v, plus, minus, cached, w, wp, wm;
+	int biasedExp = bits >> 52;
+	double dk;
+	int k;
+	uint index;
+
+	// Get value as a DiyFp.
+	if(biasedExp != 0) {
+		v.f = (bits & DblSigMask) + DblHiddenBit;
+		v.e = biasedExp - DblExpBias;
+		}
+	else {
+		v.f = bits & DblSigMask;
+		v.e = 1 - DblExpBias;
+		}
+
+	// Get boundaries of rounding interval (halfway to neighboring doubles), with the same exponent.  The lower boundary is
+	// closer if v is a power of two.
+	plus.f = (v.f << 1) + 1;
+	plus.e = v.e - 1;
+	plus = diyNormalize(plus);
+	if(v.f == DblHiddenBit && biasedExp > 1) {
+		minus.f = (v.f << 2) - 1;
+		minus.e = v.e - 2;
+		}
+	else {
+		minus.f = (v.f << 1) - 1;
+		minus.e = v.e - 1;
+		}
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+
+	// Get cached power of ten that scales the upper boundary so that its binary exponent is in range -60 to -32.
+	dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+	k = (int) dk;
+	if(dk - k > 0.0)
+		++k;
+	index = (k >> 3) + 1;
+	*pK = -(-348 + (int) index * 8);
+	cached = cachedPowers[index];
+
+	// Scale value and boundaries, shrink interval by one unit on each side to allow for rounding error in the products,
+	// and generate digits.
+	w = diyMult(diyNormalize(v), cached);
+	wp = diyMult(plus, cached);
+	wm = diyMult(minus, cached);
+	++wm.f;
+	--wp.f;
+	grisuDigits(w, wp, wp.f - wm.f, buf, pLen, pK);
+	}
+
+// Convert given double to a short string that converts back to the same value with strtod() (not always the shortest), in
+// dest, which must be at least NumBufSize bytes in size.  The format is like printf()'s "%g": fixed notation is used if the decimal exponent is in
+// range -4 to 15; otherwise, exponential notation.  Return pointer to terminating null byte.
+char *realtos(double r, char *dest) {
+	uint64_t bits;
+	char digits[24];
+	int len, K, exp10;
+
+	memcpy((void *) &bits, (void *) &r, sizeof(bits));
+
+	// Infinity or NaN?
+	if((bits & ~DblSignBit) >= 0x7FF0000000000000ull)
+		return dest + sprintf(dest, "%g", r);
+
+	// Negative?  Zero?
+	if(bits & DblSignBit) {
+		*dest++ = '-';
+		bits &= ~DblSignBit;
+		}
+	if(bits == 0) {
+		*dest++ = '0';
+		goto Retn;
+		}
+
+	// Get digits and decimal exponent of first digit.
+	grisu2(bits, digits, &len, &K);
+	exp10 = len + K - 1;
+
+	// Fixed notation?
+	if(exp10 >= FixedMin && exp10 < FixedMax) {
+		if(K >= 0) {						// Integer.
+			memcpy((void *) dest, (void *) digits, len);
+			memset((void *) (dest += len), '0', K);
+			dest += K;
+			}
+		else if(exp10 >= 0) {					// Decimal point within digits.
+			memcpy((void *) dest, (void *) digits, exp10 + 1);
+			dest += exp10 + 1;
+			*dest++ = '.';
+			memcpy((void *) dest, (void *) (digits + exp10 + 1), len - exp10 - 1);
+			dest += len - exp10 - 1;
+			}
+		else {							// Less than one.
+			*dest++ = '0';
+			*dest++ = '.';
+			memset((void *) dest, '0', -exp10 - 1);
+			dest += -exp10 - 1;
+			memcpy((void *) dest, (void *) digits, len);
+			dest += len;
+			}
+		}
+	else {
+		// Exponential notation, with at least two exponent digits.
+		*dest++ = digits[0];
+		if(len > 1) {
+			*dest++ = '.';
+			memcpy((void *) dest, (void *) (digits + 1), len - 1);
+			dest += len - 1;
+			}
+		*dest++ = 'e';
+		if(exp10 < 0) {
+			*dest++ = '-';
+			exp10 = -exp10;
+			}
+		else
+			*dest++ = '+';
+		if(exp10 < 10)
+			*dest++ = '0';
+		return uinttos(exp10, dest);
+		}
+Retn:
+	*dest = '\0';
+	return dest;
+	}
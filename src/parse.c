@@ -0,0 +1,464 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// parse.c		Routines for parsing Datum objects in text form, as produced by dtos() with DCvtLang flags.
+
+#include "stdos.h"
+#include "cxl/excep.h"
+#include "cxl/datum.h"
+#include "cxl/array.h"
+#include "cxl/fastio.h"
+#include "cxl/string.h"
+#include "cxl/lib.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Local definitions.
+#define ParseNestMax	1000			// Maximum array nesting depth.
+#define WorkBufSize	256			// Size of local buffer for converted strings and numbers.
+
+// Source text being parsed.
+typedef struct {
+	const char *buf;			// Beginning of text (for error messages).
+	const char *cur;			// Next character to parse.
+	const char *end;			// End of text.
+	} ParseSource;
+
+// Powers of ten that are exactly representable as a double.
+static const double pow10Tab[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// Set an error message for text at given position and return -1.
+static int parseErr(const ParseSource *pSrc, const char *pos, const char *msg) {
+
+	return emsgf(-1, "%s at offset %lu in parsed text", msg, (ulong) (pos - pSrc->buf));
+	}
+
+// Skip white space.
+static void skipSpace(ParseSource *pSrc) {
+
+	while(pSrc->cur < pSrc->end && (*pSrc->cur == ' ' || (*pSrc->cur >= '\t' && *pSrc->cur <= '\r')))
+		++pSrc->cur;
+	}
+
+// Return true if given keyword is at pSrc->cur (and skip over it), otherwise false.
+static bool matchWord(ParseSource *pSrc, const char *word, size_t len) {
+
+	if((size_t) (pSrc->end - pSrc->cur) < len || memcmp((void *) pSrc->cur, (void *) word, len) != 0)
+		return false;
+	pSrc->cur += len;
+	return true;
+	}
+
+// Return pointer to the first double quote, backslash, or null byte in str (before strEnd), or strEnd if none.  The string is
+// scanned eight bytes at a time.
+static const char *strSpan(const char *str, const char *strEnd) {
+	uint64_t x;
+
+	while(strEnd - str >= 8) {
+		memcpy((void *) &x, (void *) str, sizeof(x));
+		if(SwarHas(x, '"') | SwarHas(x, '\\') | SwarLess(x, 1))
+			break;
+		str += 8;
+		}
+	while(str < strEnd && *str != '"' && *str != '\\' && *str != '\0')
+		++str;
+	return str;
+	}
+
+// Convert the escape sequence following a backslash at *pStr (before strEnd), update *pStr, and return the resulting
+// character, or -1 if the sequence is invalid.  The sequences recognized by strconv() are converted, plus \b (backspace), which
+// dtos() produces.
+static short unescape(const char **pStr, const char *strEnd) {
+	short c, c2;
+	int base = 8;
+	int maxLen = 3;
+	const char *str = *pStr;
+	const char *str1;
+
+	if(str == strEnd)
+		return -1;
+	switch(c = *str++) {
+		case 't':	// Tab
+			c = '\t'; break;
+		case 'r':	// CR
+			c = '\r'; break;
+		case 'n':	// NL
+			c = '\n'; break;
+		case 'e':	// Escape
+			c = 033; break;
+		case 's':	// Space
+			c = 040; break;
+		case 'f':	// Form feed
+			c = '\f'; break;
+		case 'v':	// Vertical tab
+			c = '\v'; break;
+		case 'b':	// Backspace
+			c = '\b'; break;
+		case 'x':
+		case 'X':
+			goto IsNum;
+		case '0':
+			if(str < strEnd && *str == 'x') {
+				++str;
+IsNum:
+				base = 16;
+				maxLen = 2;
+				goto GetNum;
+				}
+			// Fall through.
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+			--str;
+GetNum:
+			// \nn found.  str is at first digit (if any).  Decode it.
+			c = 0;
+			str1 = str;
+			while(str < strEnd && maxLen > 0) {
+				c2 = *str;
+				if(c2 >= '0' && (c2 <= '7' || (c2 <= '9' && base != 8)))
+					c = c * base + (c2 - '0');
+				else {
+					if(c2 >= 'A' && c2 <= 'Z')
+						c2 += ('a' - 'A');
+					if(base == 16 && (c2 >= 'a' && c2 <= 'f'))
+						c = c * 16 + (c2 - ('a' - 10));
+					else
+						break;
+					}
+				if(c > 0xff)
+					return -1;
+				++str;
+				--maxLen;
+				}
+
+			// No digits decoded?  Use literal character.
+			if(str == str1)
+				c = str[-1];
+			break;
+		}
+
+	*pStr = str;
+	return c;
+	}
+
+// Parse a double-quoted string at pSrc->cur and save it in *pDatum as a string, or as a byte string if it contains a null byte.
+// Return status code.
+static int parseStr(Datum *pDatum, ParseSource *pSrc) {
+	const char *str = pSrc->cur + 1;
+	const char *str1, *str2, *strEnd;
+	char *dest0, *dest;
+	short c;
+	size_t len;
+	bool hasNull = false;
+	char workBuf[WorkBufSize];
+
+	// Scan to first character that is not copied literally.  If it's the closing quote, set string directly.
+	if((str1 = strSpan(str, pSrc->end)) == pSrc->end)
+		goto Unterm;
+	if(*str1 == '"') {
+		pSrc->cur = str1 + 1;
+		return dsetsubstr(str, str1 - str, pDatum);
+		}
+
+	// String contains escape sequences or null bytes.  Find closing quote to determine maximum length of result.
+	for(strEnd = str1;;) {
+		if((strEnd = strSpan(strEnd, pSrc->end)) == pSrc->end)
+			goto Unterm;
+		if(*strEnd == '"')
+			break;
+		if(*strEnd++ == '\\' && strEnd++ == pSrc->end)
+			goto Unterm;
+		}
+
+	// Get a buffer and copy the string to it, converting escape sequences.
+	len = strEnd - str;
+	if(len < sizeof(workBuf))
+		dest0 = workBuf;
+	else if((dest0 = (char *) malloc(len + 1)) == NULL)
+		return emsgsys(-1);
+	dest = (char *) memstpcpy((void *) dest0, (void *) str, str1 - str);
+	for(;;) {
+		if(*str1 == '\0') {
+			hasNull = true;
+			*dest++ = *str1++;
+			}
+		else {
+			++str1;
+			if((c = unescape(&str1, strEnd)) < 0) {
+				if(dest0 != workBuf)
+					free((void *) dest0);
+				return parseErr(pSrc, str1, "Invalid escape sequence");
+				}
+			if(c == '\0')
+				hasNull = true;
+			*dest++ = c;
+			}
+		str2 = strSpan(str1, strEnd);
+		dest = (char *) memstpcpy((void *) dest, (void *) str1, str2 - str1);
+		if((str1 = str2) == strEnd)
+			break;
+		}
+	pSrc->cur = strEnd + 1;
+
+	// Save result.
+	len = dest - dest0;
+	if(dest0 == workBuf)
+		return hasNull ? dsetmem((void *) dest0, len, pDatum) : dsetsubstr(dest0, len, pDatum);
+	if(hasNull)
+		dadoptmem((void *) dest0, len, pDatum);
+	else {
+		*dest = '\0';
+		dadoptstr(dest0, pDatum);
+		}
+	return 0;
+Unterm:
+	return parseErr(pSrc, pSrc->cur, "Unterminated string");
+	}
+
+// Parse a single-quoted character at pSrc->cur and save it in *pDatum.  Return status code.
+static int parseChar(Datum *pDatum, ParseSource *pSrc) {
+	const char *str = pSrc->cur + 1;
+	short c;
+
+	if(str == pSrc->end)
+		goto BadChar;
+	if(*str == '\\') {
+		++str;
+		if((c = unescape(&str, pSrc->end)) < 0)
+			goto BadChar;
+		}
+	else
+		c = *str++;
+	if(str == pSrc->end || *str != '\'')
+		goto BadChar;
+	pSrc->cur = str + 1;
+	dsetchr(c, pDatum);
+	return 0;
+BadChar:
+	return parseErr(pSrc, pSrc->cur, "Invalid character literal");
+	}
+
+// Parse a number at pSrc->cur and save it in *pDatum.  It is saved as a signed integer if it has no fraction or exponent and
+// fits in a long, an unsigned integer if it is positive and fits in an unsigned long, or a real number otherwise.  Return status
+// code.
+static int parseNum(Datum *pDatum, ParseSource *pSrc) {
+	const char *str = pSrc->cur;
+	const char *strEnd = pSrc->end;
+	const char *digits;
+	uint64_t mant = 0;
+	int exp10 = 0;
+	uint d;
+	double r;
+	bool minus = false, isReal = false, overflow = false;
+
+	if(*str == '-' || *str == '+')
+		minus = (*str++ == '-');
+
+	// Infinity or NaN?
+	if(str < strEnd && (*str == 'i' || *str == 'n')) {
+		pSrc->cur = str;
+		if(matchWord(pSrc, "inf", 3))
+			r = INFINITY;
+		else if(matchWord(pSrc, "nan", 3))
+			r = NAN;
+		else
+			goto BadNum;
+		goto SetReal;
+		}
+
+	// Get integer part, fraction, and exponent.  Digits are accumulated in mant as long as they fit.
+	for(digits = str; str < strEnd && (d = *str - '0') <= 9; ++str) {
+		if(mant > (UINT64_MAX - d) / 10)
+			overflow = true;
+		else
+			mant = mant * 10 + d;
+		}
+	if(str == digits)
+		goto BadNum;
+	if(str < strEnd && *str == '.') {
+		isReal = true;
+		while(++str < strEnd && (d = *str - '0') <= 9) {
+			if(mant > (UINT64_MAX - d) / 10)
+				overflow = true;
+			else {
+				mant = mant * 10 + d;
+				--exp10;
+				}
+			}
+		}
+	if(str < strEnd && (*str == 'e' || *str == 'E')) {
+		int exp = 0;
+		bool expMinus = false;
+
+		isReal = true;
+		if(++str < strEnd && (*str == '-' || *str == '+'))
+			expMinus = (*str++ == '-');
+		for(digits = str; str < strEnd && (d = *str - '0') <= 9; ++str)
+			if(exp < 100000)
+				exp = exp * 10 + d;
+		if(str == digits)
+			goto BadNum;
+		exp10 += expMinus ? -exp : exp;
+		}
+
+	// Integer?
+	if(!isReal && !overflow) {
+		if(minus) {
+			if(mant <= (uint64_t) LONG_MAX + 1) {
+				dsetint(mant == (uint64_t) LONG_MAX + 1 ? LONG_MIN : -(long) mant, pDatum);
+				goto Done;
+				}
+			}
+		else {
+			if(mant <= LONG_MAX)
+				dsetint(mant, pDatum);
+			else
+				dsetuint(mant, pDatum);
+			goto Done;
+			}
+		}
+
+	// Real number.  Compute it directly if the mantissa and power of ten are both exact doubles (so that the result is
+	// correctly rounded); otherwise, call strtod().
+	if(!overflow && mant <= (1ull << 53) && exp10 >= -22 && exp10 <= 22)
+		r = (exp10 < 0) ? (double) mant / pow10Tab[-exp10] : (double) mant * pow10Tab[exp10];
+	else {
+		char workBuf[WorkBufSize];
+
+		if((size_t) (str - pSrc->cur) >= sizeof(workBuf))
+			goto BadNum;
+		memcpy((void *) workBuf, (void *) pSrc->cur, str - pSrc->cur);
+		workBuf[str - pSrc->cur] = '\0';
+		r = strtod(minus ? workBuf + 1 : workBuf, NULL);
+		}
+	pSrc->cur = str;
+SetReal:
+	dsetreal(minus ? -r : r, pDatum);
+	return 0;
+Done:
+	pSrc->cur = str;
+	return 0;
+BadNum:
+	return parseErr(pSrc, pSrc->cur, "Invalid number");
+	}
+
+// Parse a value at pSrc->cur (after any leading white space) and save it in *pDatum.  Arrays are parsed recursively.  Return
+// status code.
+static int parseVal(Datum *pDatum, ParseSource *pSrc, uint depth) {
+
+	skipSpace(pSrc);
+	if(pSrc->cur == pSrc->end)
+		return parseErr(pSrc, pSrc->cur, "Unexpected end of text");
+
+	switch(*pSrc->cur) {
+		case '"':
+			return parseStr(pDatum, pSrc);
+		case '\'':
+			return parseChar(pDatum, pSrc);
+		case '[':
+			{Array *pArray;
+			Datum *pElement;
+
+			if(depth == ParseNestMax)
+				return parseErr(pSrc, pSrc->cur, "Arrays nested too deeply");
+			if((pArray = anew(0, NULL)) == NULL)
+				return -1;
+			++pSrc->cur;
+			skipSpace(pSrc);
+			if(pSrc->cur < pSrc->end && *pSrc->cur == ']')
+				++pSrc->cur;
+			else {
+				for(;;) {
+					if((pElement = aget(pArray, pArray->used, AOpGrow)) == NULL
+					 || parseVal(pElement, pSrc, depth + 1) != 0)
+						goto ErrRtn;
+					skipSpace(pSrc);
+					if(pSrc->cur == pSrc->end) {
+						(void) parseErr(pSrc, pSrc->cur, "Unexpected end of text");
+						goto ErrRtn;
+						}
+					if(*pSrc->cur++ == ']')
+						break;
+					if(pSrc->cur[-1] != ',') {
+						(void) parseErr(pSrc, pSrc->cur - 1, "Expected ',' or ']'");
+						goto ErrRtn;
+						}
+					}
+				}
+			dadoptarray(pArray, pDatum);
+			return 0;
+ErrRtn:
+			afree(pArray);
+			return -1;
+			}
+		case 'n':
+			if(matchWord(pSrc, "nil", 3)) {
+				dclear(pDatum);
+				return 0;
+				}
+			return parseNum(pDatum, pSrc);
+		case 't':
+			if(!matchWord(pSrc, "true", 4))
+				break;
+			dsetbool(true, pDatum);
+			return 0;
+		case 'f':
+			if(!matchWord(pSrc, "false", 5))
+				break;
+			dsetbool(false, pDatum);
+			return 0;
+		case '-':
+		case '+':
+		case 'i':
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
+			return parseNum(pDatum, pSrc);
+		}
+
+	return parseErr(pSrc, pSrc->cur, "Invalid value");
+	}
+
+// Parse a value in len bytes of text in str and save it in *pDatum.  Return the number of bytes parsed, including leading and
+// trailing white space, or -1 if error.
+ssize_t dparse(Datum *pDatum, const char *str, size_t len) {
+	ParseSource src = {str, str, str + len};
+
+	if(parseVal(pDatum, &src, 0) != 0) {
+		dclear(pDatum);
+		return -1;
+		}
+	skipSpace(&src);
+	return src.cur - str;
+	}
+
+// Read the entire contents of a data file, parse it as a value, and save it in *pDatum.  Routine assumes that no prior read
+// operations have been performed on the file.  Return status code.
+int ffparse(Datum *pDatum, FastFile *pFastFile) {
+	ssize_t len, parsed;
+
+	if((len = ffslurp(pFastFile)) < 0 || (parsed = dparse(pDatum, pFastFile->lineBuf, len)) < 0)
+		return -1;
+	if(parsed < len) {
+		dclear(pDatum);
+		return emsgf(-1, "Unexpected text at offset %lu in parsed text", (ulong) parsed);
+		}
+	return 0;
+	}
@@ -28,7 +28,7 @@ uint32_t rand32(void) {
 		uint64_t bitStream;
 		short bits;
 		} RandCtrl;
-	static RandCtrl randCtrl = {0, 0, 0};
+	static __thread RandCtrl randCtrl = {0, 0, 0};
 	uint32_t r;
 
 	if(randCtrl.randSeed == 0)
@@ -0,0 +1,834 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// vector.c		Routines for packed numeric vectors.
+//
+// Notes:
+//  1. Signed and unsigned integer elements are the same size and are added, subtracted, multiplied, and summed as unsigned
+//     integers, so that overflow wraps around (instead of being undefined) and one routine serves both types.
+//  2. Reductions (sum, minimum, etc.) are done in blocks of VecLanes elements with an independent accumulator for each lane,
+//     so that the compiler can vectorize the loops.  Consequently, the sum of real numbers may differ slightly from a
+//     sequential sum.
+
+#include "stdos.h"
+#include "cxl/excep.h"
+#include "cxl/datum.h"
+#include "cxl/array.h"
+#include "cxl/vector.h"
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define VecLanes	8		// Number of accumulators (lanes) in reduction loops.
+#define MatchNone	1		// Return codes from cmpval(): no element satisfies predicate...
+#define MatchAll	2		// or every element does.
+
+// Numeric value of any vector element type.
+typedef union {
+	long intNum;
+	ulong uintNum;
+	double realNum;
+	} VecNum;
+
+// Initialize a vector as empty, given element type.
+void vinit(Vector *pVec, DatumType type) {
+
+	pVec->type = type;
+	pVec->used = pVec->size = 0;
+	pVec->u.ptr = NULL;
+	}
+
+// Clear a vector: release element storage (if any) and set used size to zero.
+void vclear(Vector *pVec) {
+
+	if(pVec->u.ptr != NULL)
+		free(pVec->u.ptr);
+	pVec->used = pVec->size = 0;
+	pVec->u.ptr = NULL;
+	}
+
+// Free a vector.
+void vfree(Vector *pVec) {
+
+	vclear(pVec);
+	free((void *) pVec);
+	}
+
+// Return size of an element of given vector.
+static size_t elSize(const Vector *pVec) {
+
+	return pVec->type == dat_real ? sizeof(double) : sizeof(long);
+	}
+
+// Check if vector needs to grow so that it has room for at least minSize elements, and grow it if so.  Return status code.
+static int need(Vector *pVec, ArraySize minSize) {
+
+	if(minSize > pVec->size) {
+		void *ptr;
+		ArraySize newSize = (pVec->size == 0) ? VecChunkSize : pVec->size;
+
+		if(minSize > VecSizeMax)
+			return emsgf(-1, "Cannot grow vector beyond maximum size (%ld)", VecSizeMax);
+		while(newSize < minSize)
+			newSize = (VecSizeMax - newSize < newSize) ? VecSizeMax : newSize * 2;
+		if((ptr = realloc(pVec->u.ptr, newSize * elSize(pVec))) == NULL) {
+			cxlExcep.flags |= ExcepMem;
+			return emsgf(-1, "%s, allocating %ld-element vector", strerror(errno), newSize);
+			}
+		pVec->u.ptr = ptr;
+		pVec->size = newSize;
+		}
+	return 0;
+	}
+
+// Create a vector (in heap space) of given element type and return pointer to it, or NULL if error.  If len > 0, create that
+// number of elements and set them to zero.
+Vector *vnew(DatumType type, ArraySize len) {
+	Vector *pVec;
+
+	if(type != dat_int && type != dat_uint && type != dat_real) {
+		emsgf(-1, "Invalid vector element type (%hu)", type);
+		return NULL;
+		}
+	if(len < 0) {
+		emsgf(-1, "Invalid vector length (%ld)", len);
+		return NULL;
+		}
+
+	if((pVec = (Vector *) malloc(sizeof(Vector))) == NULL) {	// Get space for vector object...
+		cxlExcep.flags |= ExcepMem;
+		emsgsys(-1);
+		return NULL;
+		}
+	vinit(pVec, type);						// initialize empty vector...
+	if(len > 0) {							// create elements if requested...
+		if(need(pVec, len) != 0) {
+			vfree(pVec);
+			return NULL;
+			}
+		memset(pVec->u.ptr, 0, len * elSize(pVec));
+		pVec->used = len;
+		}
+	return pVec;							// and return it.
+	}
+
+// Clone a vector and return pointer to new vector, or NULL if error.
+Vector *vclone(const Vector *pVec) {
+	Vector *pVec1;
+
+	if((pVec1 = vnew(pVec->type, 0)) != NULL && pVec->used > 0) {
+		if(need(pVec1, pVec->used) != 0) {
+			vfree(pVec1);
+			return NULL;
+			}
+		memcpy(pVec1->u.ptr, pVec->u.ptr, pVec->used * elSize(pVec));
+		pVec1->used = pVec->used;
+		}
+	return pVec1;
+	}
+
+// Convert a numeric Datum object to given vector element type and store result in *pNum.  Return status code.  It is an error
+// if the number is out of range for the type, or is a real number that is not an integer and the type is an integer type.
+static int numval(VecNum *pNum, DatumType type, const Datum *pVal) {
+	double d;
+
+	switch(pVal->type) {
+		case dat_int:
+			if(type == dat_real)
+				pNum->realNum = pVal->u.intNum;
+			else if(type == dat_uint && pVal->u.intNum < 0)
+				return emsgf(-1, "Integer %ld out of range for unsigned integer vector", pVal->u.intNum);
+			else
+				pNum->intNum = pVal->u.intNum;
+			return 0;
+		case dat_uint:
+			if(type == dat_real)
+				pNum->realNum = pVal->u.uintNum;
+			else if(type == dat_int && pVal->u.uintNum > LONG_MAX)
+				return emsgf(-1, "Unsigned integer %lu out of range for signed integer vector", pVal->u.uintNum);
+			else
+				pNum->uintNum = pVal->u.uintNum;
+			return 0;
+		case dat_real:
+			d = pVal->u.realNum;
+			if(type == dat_real)
+				pNum->realNum = d;
+			else if(type == dat_int ? !(d >= (double) LONG_MIN && d < -(double) LONG_MIN) :
+			 !(d >= 0.0 && d < -2.0 * (double) LONG_MIN))
+				return emsgf(-1, "Real number %g out of range for integer vector", d);
+			else if(d != floor(d))
+				return emsgf(-1, "Real number %g is not an integer", d);
+			else if(type == dat_int)
+				pNum->intNum = d;
+			else
+				pNum->uintNum = d;
+			return 0;
+		}
+	return emsg(-1, "Vector value must be a number");
+	}
+
+// Append a number to a vector, converting it to the vector's element type.  Return status code.
+int vpush(Vector *pVec, const Datum *pVal) {
+	VecNum num;
+
+	if(numval(&num, pVec->type, pVal) != 0 || need(pVec, pVec->used + 1) != 0)
+		return -1;
+	switch(pVec->type) {
+		case dat_int:
+			pVec->u.intNums[pVec->used] = num.intNum;
+			break;
+		case dat_uint:
+			pVec->u.uintNums[pVec->used] = num.uintNum;
+			break;
+		default:
+			pVec->u.realNums[pVec->used] = num.realNum;
+		}
+	++pVec->used;
+	return 0;
+	}
+
+// Create a vector from an array of numbers and return it, or NULL if error.  If type is dat_nil, the element type is chosen so
+// that every element is in range: dat_real if the array contains any real numbers, or both negative integers and unsigned
+// integers greater than LONG_MAX; otherwise, dat_uint if it contains no negative integers and either no signed integers or
+// some unsigned integers greater than LONG_MAX; otherwise, dat_int.
+Vector *vfromarray(const Array *pArray, DatumType type) {
+	Vector *pVec;
+	Datum *pArrayEl, *pArrayElEnd;
+
+	pArrayElEnd = (pArrayEl = pArray->elements) + pArray->used;
+	if(type == dat_nil) {
+		bool anyInt = false, anyNeg = false, anyBig = false;
+
+		for(; pArrayEl < pArrayElEnd; ++pArrayEl)
+			if(pArrayEl->type == dat_real)
+				break;
+			else if(pArrayEl->type == dat_int) {
+				anyInt = true;
+				if(pArrayEl->u.intNum < 0)
+					anyNeg = true;
+				}
+			else if(pArrayEl->type == dat_uint && pArrayEl->u.uintNum > LONG_MAX)
+				anyBig = true;
+		type = (pArrayEl < pArrayElEnd || (anyNeg && anyBig)) ? dat_real : (anyBig || !anyInt) ? dat_uint : dat_int;
+		pArrayEl = pArray->elements;
+		}
+	if((pVec = vnew(type, 0)) == NULL)
+		return NULL;
+	if(need(pVec, pArray->used) != 0)
+		goto ErrRetn;
+	for(; pArrayEl < pArrayElEnd; ++pArrayEl)
+		if(vpush(pVec, pArrayEl) != 0) {
+			(void) emsgf(-1, "Array element %ld is not a number or cannot be converted to vector element type",
+			 pArrayEl - pArray->elements);
+			goto ErrRetn;
+			}
+	return pVec;
+ErrRetn:
+	vfree(pVec);
+	return NULL;
+	}
+
+// Store a vector element in a Datum object.
+static void elget(Datum *pDatum, const Vector *pVec, ArraySize index) {
+
+	switch(pVec->type) {
+		case dat_int:
+			dsetint(pVec->u.intNums[index], pDatum);
+			break;
+		case dat_uint:
+			dsetuint(pVec->u.uintNums[index], pDatum);
+			break;
+		default:
+			dsetreal(pVec->u.realNums[index], pDatum);
+		}
+	}
+
+// Create an array from a vector and return it, or NULL if error.
+Array *vtoarray(const Vector *pVec) {
+	Array *pArray;
+
+	if((pArray = anew(pVec->used, NULL)) != NULL) {
+		Datum *pArrayEl = pArray->elements;
+		ArraySize index;
+
+		for(index = 0; index < pVec->used; ++index)
+			elget(pArrayEl++, pVec, index);
+		}
+	return pArray;
+	}
+
+// Return sum of n integers in p (wrapping on overflow).
+static ulong sumInts(const ulong *p, ArraySize n) {
+	ulong acc[VecLanes] = {0};
+	ulong sum = 0;
+	const ulong *pEnd = p + (n - n % VecLanes);
+	int i;
+
+	for(; p < pEnd; p += VecLanes)
+		for(i = 0; i < VecLanes; ++i)
+			acc[i] += p[i];
+	for(i = 0; i < VecLanes; ++i)
+		sum += acc[i];
+	for(pEnd += n % VecLanes; p < pEnd; ++p)
+		sum += *p;
+	return sum;
+	}
+
+// Return sum of n real numbers in p.
+static double sumReals(const double *p, ArraySize n) {
+	double acc[VecLanes] = {0.0};
+	double sum = 0.0;
+	const double *pEnd = p + (n - n % VecLanes);
+	int i;
+
+	for(; p < pEnd; p += VecLanes)
+		for(i = 0; i < VecLanes; ++i)
+			acc[i] += p[i];
+	for(i = 0; i < VecLanes; ++i)
+		sum += acc[i];
+	for(pEnd += n % VecLanes; p < pEnd; ++p)
+		sum += *p;
+	return sum;
+	}
+
+// Return sum of n signed or unsigned integers in p as a real number (so that it does not overflow).
+static double sumIntsReal(const void *p, ArraySize n, bool isSigned) {
+	double acc[VecLanes] = {0.0};
+	double sum = 0.0;
+	ArraySize i = 0;
+	int j;
+
+	if(isSigned) {
+		const long *pInt = (const long *) p;
+		for(; i + VecLanes <= n; i += VecLanes)
+			for(j = 0; j < VecLanes; ++j)
+				acc[j] += pInt[i + j];
+		for(; i < n; ++i)
+			sum += pInt[i];
+		}
+	else {
+		const ulong *pUint = (const ulong *) p;
+		for(; i + VecLanes <= n; i += VecLanes)
+			for(j = 0; j < VecLanes; ++j)
+				acc[j] += pUint[i + j];
+		for(; i < n; ++i)
+			sum += pUint[i];
+		}
+	for(j = 0; j < VecLanes; ++j)
+		sum += acc[j];
+	return sum;
+	}
+
+// Store sum of vector elements in *pDatum (as the vector's element type).  Integer sums wrap around on overflow.
+void vsum(Datum *pDatum, const Vector *pVec) {
+
+	switch(pVec->type) {
+		case dat_int:
+			dsetint((long) sumInts(pVec->u.uintNums, pVec->used), pDatum);
+			break;
+		case dat_uint:
+			dsetuint(sumInts(pVec->u.uintNums, pVec->used), pDatum);
+			break;
+		default:
+			dsetreal(sumReals(pVec->u.realNums, pVec->used), pDatum);
+		}
+	}
+
+// Store arithmetic mean of vector elements in *pDatum as a real number, or nil if vector is empty.
+void vmean(Datum *pDatum, const Vector *pVec) {
+
+	if(pVec->used == 0)
+		dsetnil(pDatum);
+	else
+		dsetreal((pVec->type == dat_real ? sumReals(pVec->u.realNums, pVec->used) :
+		 sumIntsReal(pVec->u.ptr, pVec->used, pVec->type == dat_int)) / pVec->used, pDatum);
+	}
+
+// Return minimum (or maximum if "max" is true) of n signed integers in p, which must be at least one.
+static long extInts(const long *p, ArraySize n, bool max) {
+	long acc[VecLanes];
+	long ext = p[0];
+	ArraySize i = 0;
+	int j;
+
+	if(n >= VecLanes) {
+		for(j = 0; j < VecLanes; ++j)
+			acc[j] = p[j];
+		if(max) {
+			for(i = VecLanes; i + VecLanes <= n; i += VecLanes)
+				for(j = 0; j < VecLanes; ++j)
+					acc[j] = p[i + j] > acc[j] ? p[i + j] : acc[j];
+			}
+		else {
+			for(i = VecLanes; i + VecLanes <= n; i += VecLanes)
+				for(j = 0; j < VecLanes; ++j)
+					acc[j] = p[i + j] < acc[j] ? p[i + j] : acc[j];
+			}
+		for(j = 0; j < VecLanes; ++j)
+			if(max ? acc[j] > ext : acc[j] < ext)
+				ext = acc[j];
+		}
+	for(; i < n; ++i)
+		if(max ? p[i] > ext : p[i] < ext)
+			ext = p[i];
+	return ext;
+	}
+
+// Return minimum (or maximum if "max" is true) of n unsigned integers in p, which must be at least one.
+static ulong extUints(const ulong *p, ArraySize n, bool max) {
+	ulong acc[VecLanes];
+	ulong ext = p[0];
+	ArraySize i = 0;
+	int j;
+
+	if(n >= VecLanes) {
+		for(j = 0; j < VecLanes; ++j)
+			acc[j] = p[j];
+		if(max) {
+			for(i = VecLanes; i + VecLanes <= n; i += VecLanes)
+				for(j = 0; j < VecLanes; ++j)
+					acc[j] = p[i + j] > acc[j] ? p[i + j] : acc[j];
+			}
+		else {
+			for(i = VecLanes; i + VecLanes <= n; i += VecLanes)
+				for(j = 0; j < VecLanes; ++j)
+					acc[j] = p[i + j] < acc[j] ? p[i + j] : acc[j];
+			}
+		for(j = 0; j < VecLanes; ++j)
+			if(max ? acc[j] > ext : acc[j] < ext)
+				ext = acc[j];
+		}
+	for(; i < n; ++i)
+		if(max ? p[i] > ext : p[i] < ext)
+			ext = p[i];
+	return ext;
+	}
+
+// Return minimum (or maximum if "max" is true) of n real numbers in p, which must be at least one.  NaN values are ignored
+// unless all values are NaN.
+static double extReals(const double *p, ArraySize n, bool max) {
+	double acc[VecLanes];
+	double ext = NAN;
+	ArraySize i = 0;
+	int j;
+
+	if(n >= VecLanes) {
+		for(j = 0; j < VecLanes; ++j)
+			acc[j] = p[j];
+		if(max) {
+			for(i = VecLanes; i + VecLanes <= n; i += VecLanes)
+				for(j = 0; j < VecLanes; ++j)
+					acc[j] = p[i + j] > acc[j] || acc[j] != acc[j] ? p[i + j] : acc[j];
+			}
+		else {
+			for(i = VecLanes; i + VecLanes <= n; i += VecLanes)
+				for(j = 0; j < VecLanes; ++j)
+					acc[j] = p[i + j] < acc[j] || acc[j] != acc[j] ? p[i + j] : acc[j];
+			}
+		for(j = 0; j < VecLanes; ++j)
+			if((max ? acc[j] > ext : acc[j] < ext) || ext != ext)
+				ext = acc[j];
+		}
+	for(; i < n; ++i)
+		if((max ? p[i] > ext : p[i] < ext) || ext != ext)
+			ext = p[i];
+	return ext;
+	}
+
+// Store minimum (or maximum if "max" is true) of vector elements in *pDatum (as the vector's element type), or nil if vector
+// is empty.
+static void extreme(Datum *pDatum, const Vector *pVec, bool max) {
+
+	if(pVec->used == 0)
+		dsetnil(pDatum);
+	else
+		switch(pVec->type) {
+			case dat_int:
+				dsetint(extInts(pVec->u.intNums, pVec->used, max), pDatum);
+				break;
+			case dat_uint:
+				dsetuint(extUints(pVec->u.uintNums, pVec->used, max), pDatum);
+				break;
+			default:
+				dsetreal(extReals(pVec->u.realNums, pVec->used, max), pDatum);
+			}
+	}
+
+// Store minimum of vector elements in *pDatum (as the vector's element type), or nil if vector is empty.
+void vmin(Datum *pDatum, const Vector *pVec) {
+
+	extreme(pDatum, pVec, false);
+	}
+
+// Store maximum of vector elements in *pDatum (as the vector's element type), or nil if vector is empty.
+void vmax(Datum *pDatum, const Vector *pVec) {
+
+	extreme(pDatum, pVec, true);
+	}
+
+// Convert the value of a predicate to a vector's element type and store result in *pNum.  The comparison is exact: a real
+// number compared with integer elements is rounded in the direction that preserves the predicate (for example, x < 3.5 becomes
+// x < 4 and x <= 3.5 becomes x <= 3), and a value that is out of range for the element type, NaN, or (for VCmpEQ and VCmpNE) not
+// an integer satisfies the predicate for every element or for none.  Return MatchAll or MatchNone in those cases, otherwise
+// zero, or -1 if error.
+static int cmpval(VecNum *pNum, const Vector *pVec, ushort cmp, const Datum *pVal) {
+	int where = 0;		// -1 if value below range of element type, 1 if above.
+
+	if(pVec->type != dat_real)
+		switch(pVal->type) {
+			case dat_int:
+				if(pVec->type == dat_uint && pVal->u.intNum < 0)
+					where = -1;
+				break;
+			case dat_uint:
+				if(pVec->type == dat_int && pVal->u.uintNum > LONG_MAX)
+					where = 1;
+				break;
+			case dat_real:
+				{double d = pVal->u.realNum;
+
+				if(isnan(d) || ((cmp == VCmpEQ || cmp == VCmpNE) && d != floor(d)))
+					return cmp == VCmpNE ? MatchAll : MatchNone;
+				if(cmp == VCmpLT || cmp == VCmpGE)
+					d = ceil(d);
+				else
+					d = floor(d);
+				if(d < (pVec->type == dat_int ? (double) LONG_MIN : 0.0))
+					where = -1;
+				else if(d >= (pVec->type == dat_int ? -(double) LONG_MIN : -2.0 * (double) LONG_MIN))
+					where = 1;
+				else {
+					if(pVec->type == dat_int)
+						pNum->intNum = d;
+					else
+						pNum->uintNum = d;
+					return 0;
+					}
+				}
+			}
+	if(where == 0)
+		return numval(pNum, pVec->type, pVal);
+
+	// Value is out of range, so every element is on the same side of it.
+	return (where < 0 ? cmp == VCmpNE || cmp == VCmpGT || cmp == VCmpGE : cmp == VCmpNE || cmp == VCmpLT || cmp == VCmpLE) ?
+	 MatchAll : MatchNone;
+	}
+
+// Find vector elements that satisfy a predicate, given comparison operator and value (which is converted to the vector's element
+// type).  If pDest is not NULL, copy the matching elements to it (which must have room for all the elements of pVec, and may be
+// pVec itself).  Return number of matching elements, or -1 if error.  The predicate is converted to a range test, lo <= x <= hi,
+// optionally inverted, so that each element is checked without branching.
+static ArraySize match(const Vector *pVec, ushort cmp, const Datum *pVal, void *pDest) {
+	VecNum num;
+	ArraySize i, n = 0;
+	uint invert = 0;
+
+	if(cmp < VCmpEQ || cmp > VCmpGE)
+		return emsgf(-1, "Invalid comparison operator (%hu)", cmp);
+	switch(cmpval(&num, pVec, cmp, pVal)) {
+		case -1:
+			return -1;
+		case MatchNone:
+			return 0;
+		case MatchAll:
+			if(pDest != NULL && pDest != pVec->u.ptr)
+				memcpy(pDest, pVec->u.ptr, pVec->used * elSize(pVec));
+			return pVec->used;
+		}
+	if(cmp == VCmpNE) {
+		cmp = VCmpEQ;
+		invert = 1;
+		}
+
+	if(pVec->type == dat_real) {
+		const double *p = pVec->u.realNums;
+		double *pOut = (double *) pDest;
+		double v = num.realNum;
+		double lo = -INFINITY, hi = INFINITY;
+
+		// A NaN bound makes the range empty.  NaN elements are never in range, so they satisfy VCmpNE only.
+		switch(cmp) {
+			case VCmpEQ:
+				lo = hi = v;
+				break;
+			case VCmpLT:
+				hi = (v == -INFINITY) ? NAN : nextafter(v, -INFINITY);
+				break;
+			case VCmpLE:
+				hi = v;
+				break;
+			case VCmpGT:
+				lo = (v == INFINITY) ? NAN : nextafter(v, INFINITY);
+				break;
+			default:	// VCmpGE
+				lo = v;
+			}
+		if(pOut == NULL)
+			for(i = 0; i < pVec->used; ++i)
+				n += ((p[i] >= lo) & (p[i] <= hi)) ^ invert;
+		else
+			for(i = 0; i < pVec->used; ++i) {
+				double x = p[i];
+				pOut[n] = x;
+				n += ((x >= lo) & (x <= hi)) ^ invert;
+				}
+		}
+	else {
+		// Signed integers are mapped to unsigned ones in the same order by flipping the sign bit, so that the range test is
+		// one subtraction and one unsigned comparison: x - lo <= hi - lo.  An empty range is expressed as the inverse of the
+		// full range.
+		const ulong *p = pVec->u.uintNums;
+		ulong *pOut = (ulong *) pDest;
+		ulong bias = (pVec->type == dat_int) ? (ulong) LONG_MIN : 0;
+		ulong v = num.uintNum ^ bias;
+		ulong lo = 0, hi = ULONG_MAX;
+
+		switch(cmp) {
+			case VCmpEQ:
+				lo = hi = v;
+				break;
+			case VCmpLT:
+				if(v == 0)
+					invert = 1;
+				else
+					hi = v - 1;
+				break;
+			case VCmpLE:
+				hi = v;
+				break;
+			case VCmpGT:
+				if(v == ULONG_MAX)
+					invert = 1;
+				else
+					lo = v + 1;
+				break;
+			default:	// VCmpGE
+				lo = v;
+			}
+		hi -= lo;
+		if(pOut == NULL)
+			for(i = 0; i < pVec->used; ++i)
+				n += ((p[i] ^ bias) - lo <= hi) ^ invert;
+		else
+			for(i = 0; i < pVec->used; ++i) {
+				ulong x = p[i];
+				pOut[n] = x;
+				n += ((x ^ bias) - lo <= hi) ^ invert;
+				}
+		}
+	return n;
+	}
+
+// Return number of vector elements that satisfy a predicate, given comparison operator and value, or -1 if error.
+ArraySize vcount(const Vector *pVec, ushort cmp, const Datum *pVal) {
+
+	return match(pVec, cmp, pVal, NULL);
+	}
+
+// Return new vector (or pVec if VOpInPlace flag set) of elements from *pVec that satisfy a predicate, given comparison operator
+// and value.  Return NULL if error.
+Vector *vfilter(Vector *pVec, ushort cmp, const Datum *pVal, ushort vflags) {
+	Vector *pVec1;
+	ArraySize n;
+
+	if(vflags & VOpInPlace)
+		pVec1 = pVec;
+	else if((pVec1 = vnew(pVec->type, 0)) == NULL)
+		return NULL;
+	else if(need(pVec1, pVec->used) != 0)
+		goto ErrRetn;
+	if((n = match(pVec, cmp, pVal, pVec1->u.ptr)) < 0)
+		goto ErrRetn;
+	pVec1->used = n;
+	return pVec1;
+ErrRetn:
+	if(pVec1 != pVec)
+		vfree(pVec1);
+	return NULL;
+	}
+
+// Apply an arithmetic operator to n integer elements in pA (as unsigned integers), with the corresponding elements in pB as the
+// second operand, or b if pB is NULL.  Division is not done here.
+static void calcInts(ulong *pA, const ulong *pB, ulong b, ArraySize n, ushort op) {
+	ArraySize i;
+
+	switch(op) {
+		case VCalcAdd:
+			if(pB == NULL)
+				for(i = 0; i < n; ++i)
+					pA[i] += b;
+			else
+				for(i = 0; i < n; ++i)
+					pA[i] += pB[i];
+			break;
+		case VCalcSub:
+			if(pB == NULL)
+				for(i = 0; i < n; ++i)
+					pA[i] -= b;
+			else
+				for(i = 0; i < n; ++i)
+					pA[i] -= pB[i];
+			break;
+		default:	// VCalcMul
+			if(pB == NULL)
+				for(i = 0; i < n; ++i)
+					pA[i] *= b;
+			else
+				for(i = 0; i < n; ++i)
+					pA[i] *= pB[i];
+		}
+	}
+
+// Apply an arithmetic operator to n real number elements in pA, with the corresponding elements in pB as the second operand, or
+// b if pB is NULL.
+static void calcReals(double *pA, const double *pB, double b, ArraySize n, ushort op) {
+	ArraySize i;
+
+	switch(op) {
+		case VCalcAdd:
+			if(pB == NULL)
+				for(i = 0; i < n; ++i)
+					pA[i] += b;
+			else
+				for(i = 0; i < n; ++i)
+					pA[i] += pB[i];
+			break;
+		case VCalcSub:
+			if(pB == NULL)
+				for(i = 0; i < n; ++i)
+					pA[i] -= b;
+			else
+				for(i = 0; i < n; ++i)
+					pA[i] -= pB[i];
+			break;
+		case VCalcMul:
+			if(pB == NULL)
+				for(i = 0; i < n; ++i)
+					pA[i] *= b;
+			else
+				for(i = 0; i < n; ++i)
+					pA[i] *= pB[i];
+			break;
+		default:	// VCalcDiv
+			if(pB == NULL)
+				for(i = 0; i < n; ++i)
+					pA[i] /= b;
+			else
+				for(i = 0; i < n; ++i)
+					pA[i] /= pB[i];
+		}
+	}
+
+// Divide n integer elements in pA by the corresponding elements in pB, or b if pB is NULL.  Return status code.
+static int divInts(Vector *pVec, const void *pB, VecNum b) {
+	ArraySize i, n = pVec->used;
+
+	// Check for division by zero first, so that the vector is not changed if an error occurs.
+	if(pB == NULL) {
+		if(b.uintNum == 0)
+			goto DivZero;
+		}
+	else
+		for(i = 0; i < n; ++i)
+			if(((const ulong *) pB)[i] == 0)
+				goto DivZero;
+
+	if(pVec->type == dat_int) {
+		long *pA = pVec->u.intNums;
+		const long *pBInt = (const long *) pB;
+
+		// Dividing by -1 is done by negation (which wraps LONG_MIN around to itself instead of overflowing).
+		for(i = 0; i < n; ++i) {
+			long d = (pBInt == NULL) ? b.intNum : pBInt[i];
+			pA[i] = (d == -1) ? (long) -(ulong) pA[i] : pA[i] / d;
+			}
+		}
+	else {
+		ulong *pA = pVec->u.uintNums;
+		const ulong *pBUint = (const ulong *) pB;
+
+		for(i = 0; i < n; ++i)
+			pA[i] /= (pBUint == NULL) ? b.uintNum : pBUint[i];
+		}
+	return 0;
+DivZero:
+	return emsg(-1, "Division by zero in vector calculation");
+	}
+
+// Apply an arithmetic operator element-wise to vector *pVec, with the elements of pB (which must be the same type and length)
+// as the second operand, or b if pB is NULL.  Return status code.
+static int calc(Vector *pVec, ushort op, const void *pB, VecNum b) {
+
+	if(op < VCalcAdd || op > VCalcDiv)
+		return emsgf(-1, "Invalid arithmetic operator (%hu)", op);
+	if(pVec->type == dat_real)
+		calcReals(pVec->u.realNums, (const double *) pB, b.realNum, pVec->used, op);
+	else if(op == VCalcDiv)
+		return divInts(pVec, pB, b);
+	else
+		calcInts(pVec->u.uintNums, (const ulong *) pB, b.uintNum, pVec->used, op);
+	return 0;
+	}
+
+// Apply an arithmetic operator element-wise to vectors *pVec1 and *pVec2 and store results in *pVec1.  The vectors must have the
+// same element type and length and may be the same vector.  Integer overflow wraps around.  Return status code.
+int vcalc(Vector *pVec1, ushort op, const Vector *pVec2) {
+	VecNum b;
+
+	if(pVec1->type != pVec2->type)
+		return emsg(-1, "Vector element types differ");
+	if(pVec1->used != pVec2->used)
+		return emsgf(-1, "Vector lengths differ (%ld and %ld)", pVec1->used, pVec2->used);
+	b.uintNum = 0;
+	return calc(pVec1, op, pVec2->u.ptr, b);
+	}
+
+// Apply an arithmetic operator to each element of vector *pVec, with given number (which is converted to the vector's element
+// type) as the second operand.  Integer overflow wraps around.  Return status code.
+int vcalcn(Vector *pVec, ushort op, const Datum *pVal) {
+	VecNum b;
+
+	return numval(&b, pVec->type, pVal) != 0 ? -1 : calc(pVec, op, NULL, b);
+	}
+
+// Write a vector in string form to a fabrication object per cflags, via calls to dputd(), and return status code.  Brackets and
+// delimiters are written as they are by aput().
+int vput(const Vector *pVec, DFab *pFab, const char *delim, ushort cflags) {
+	Datum datum;
+	ArraySize index;
+	const char *realDelim = delim != NULL ? delim : cflags & ACvtDelim ? ", " : NULL;
+
+	if((pFab->flags & FabModeMask) == FabPrepend) {
+		DFab fab, *pTempFab;
+
+		return (pTempFab = bopentemp(&fab)) == NULL ? -1 : bputfab(pTempFab, pFab, vput(pVec, pTempFab, delim, cflags));
+		}
+
+	dinit(&datum);
+	if((cflags & (ACvtBrkts | ACvtNoBrkts)) == ACvtBrkts && bputc('[', pFab) != 0)
+		return -1;
+	for(index = 0; index < pVec->used; ++index) {
+		if(index > 0 && realDelim != NULL && bputs(realDelim, pFab) != 0)
+			return -1;
+		elget(&datum, pVec, index);
+		if(dputd(&datum, pFab, delim, cflags) != 0)
+			return -1;
+		}
+	return (cflags & (ACvtBrkts | ACvtNoBrkts)) == ACvtBrkts && bputc(']', pFab) != 0 ? -1 : 0;
+	}
+
+// Convert vector in *pVec to string per cflags and store in *pDatum.  Return status code.
+int vtos(Datum *pDatum, const Vector *pVec, const char *delim, ushort cflags) {
+	DFab fab;
+
+	if(dopenwith(&fab, pDatum, FabClear) != 0)
+		return -1;
+	if(vput(pVec, &fab, delim, cflags) != 0) {
+		(void) dclose(&fab, FabStr);
+		return -1;
+		}
+	return dclose(&fab, FabStr);
+	}
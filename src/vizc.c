@@ -8,7 +8,6 @@
 #include "stdos.h"
 #include "cxl/excep.h"
 #include "cxl/string.h"
-#include <stdio.h>
 
 // Return character c as a string, converting to visible form if non-text, as follows:
 //	<NL>	012	Newline.
@@ -22,7 +21,7 @@
 // If an error occurs, an exception message is set and NULL is returned.
 char *vizc(short c, ushort flags) {
 	ushort base;
-	static char literal[6];
+	static __thread char literal[6];
 
 	// Valid base?
 	if((base = flags & VizBaseMask) > VizBaseMax) {
@@ -53,14 +52,26 @@ DoChar:
 			if(c < 0 || c > 0xFF)
 				return "<?>";
 			else {
-				char *fmt;
+				char *str = literal;
 				if(c <= 0x7F) {
-					fmt = "^%c";
-					c ^= 0x40;
+					*str++ = '^';
+					*str++ = c ^ 0x40;
 					}
-				else
-					fmt = (base == VizBaseOctal) ? "<%.3o>" : (base == VizBaseHex) ? "<%.2x>" : "<%.2X>";
-				sprintf(literal, fmt, c);
+				else {
+					*str++ = '<';
+					if(base == VizBaseOctal) {
+						*str++ = '0' + (c >> 6);
+						*str++ = '0' + ((c >> 3) & 7);
+						*str++ = '0' + (c & 7);
+						}
+					else {
+						const char *digits = (base == VizBaseHex) ? "0123456789abcdef" : "0123456789ABCDEF";
+						*str++ = digits[c >> 4];
+						*str++ = digits[c & 0xF];
+						}
+					*str++ = '>';
+					}
+				*str = '\0';
 				}
 		}
 
@@ -0,0 +1,165 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// encodeTest.c		Test that dencode() and ddecode() round-trip random datums and reject malformed data.
+
+#include "test.h"
+
+#define RandomCount	20000		// Number of random datums to round-trip.
+#define SeqCount	2000		// Number of random datum sequences to encode and decode back-to-back.
+#define SeqLen		5		// Number of datums in each sequence.
+#define NestDepth	4		// Maximum array nesting depth of random datums.
+
+// Encode given datum into *pEnc as a byte string.  Return status code.
+static int encode(const Datum *pDatum, Datum *pEnc) {
+	DFab fab;
+	int status;
+
+	if(dopenwith(&fab, pEnc, FabClear) != 0)
+		return -1;
+	status = dencode(pDatum, &fab);
+	return dclose(&fab, FabMem) != 0 ? -1 : status;
+	}
+
+// Encode and decode a datum, with and without the DDecRef flag, and check the results.  Also check that every proper prefix
+// of the encoded data (which is truncated) is rejected.
+static void roundTrip(const Datum *pDatum, bool prefixes) {
+	Datum enc, dec;
+	ssize_t n;
+
+	dinit(&enc);
+	dinit(&dec);
+	check(encode(pDatum, &enc) == 0);
+	for(ushort flags = 0; flags <= DDecRef; flags += DDecRef) {
+		check((n = ddecode(&dec, enc.u.mem.ptr, enc.u.mem.size, flags)) == (ssize_t) enc.u.mem.size);
+		check(n < 0 || deq(&dec, pDatum, 0));
+		dclear(&dec);
+		}
+	if(prefixes)
+		for(size_t size = 0; size < enc.u.mem.size; ++size) {
+			check(ddecode(&dec, enc.u.mem.ptr, size, 0) < 0);
+			dclear(&dec);
+			}
+	dclear(&enc);
+	}
+
+// Round-trip random datums.
+static void testRandom(void) {
+	Datum datum;
+
+	dinit(&datum);
+	for(int n = 0; n < RandomCount; ++n) {
+		randDatum(&datum, n % (NestDepth + 1));
+		roundTrip(&datum, n % 20 == 0);
+		}
+	dclear(&datum);
+	}
+
+// Encode several datums into one buffer and decode them back one at a time.
+static void testSequence(void) {
+	Datum datums[SeqLen], enc, dec;
+	DFab fab;
+	const char *cur, *end;
+	ssize_t n;
+
+	dinit(&enc);
+	dinit(&dec);
+	for(int i = 0; i < SeqLen; ++i)
+		dinit(datums + i);
+	for(int count = 0; count < SeqCount; ++count) {
+		check(dopenwith(&fab, &enc, FabClear) == 0);
+		for(int i = 0; i < SeqLen; ++i) {
+			randDatum(datums + i, NestDepth);
+			check(dencode(datums + i, &fab) == 0);
+			}
+		check(dclose(&fab, FabMem) == 0);
+		cur = enc.u.mem.ptr;
+		end = cur + enc.u.mem.size;
+		for(int i = 0; i < SeqLen; ++i) {
+			if((n = ddecode(&dec, cur, end - cur, 0)) < 0) {
+				check(n >= 0);
+				break;
+				}
+			check(deq(&dec, datums + i, 0));
+			cur += n;
+			}
+		check(cur == end);
+		}
+	for(int i = 0; i < SeqLen; ++i)
+		dclear(datums + i);
+	dclear(&enc);
+	dclear(&dec);
+	}
+
+// Decode encoded data with random bytes changed.  The result does not matter, only that the call returns.
+static void testCorrupt(void) {
+	Datum datum, enc, dec;
+	char *buf;
+
+	dinit(&datum);
+	dinit(&enc);
+	dinit(&dec);
+	for(int n = 0; n < RandomCount; ++n) {
+		randDatum(&datum, NestDepth);
+		check(encode(&datum, &enc) == 0);
+		buf = enc.u.mem.ptr;
+		for(int i = rand64() % 4; i >= 0 && enc.u.mem.size > 0; --i)
+			buf[rand64() % enc.u.mem.size] = rand64();
+		(void) ddecode(&dec, buf, enc.u.mem.size, n % 2 ? DDecRef : 0);
+		dclear(&dec);
+		}
+	dclear(&datum);
+	dclear(&enc);
+	}
+
+// Create an array nested "depth" levels deep in *pDatum.  Return status code.
+static int nest(Datum *pDatum, int depth) {
+	Array *pArray;
+
+	dsetnil(pDatum);
+	while(depth-- > 0) {
+		if((pArray = anew(1, NULL)) == NULL)
+			return -1;
+		dxfer(pArray->elements, pDatum);
+		dadoptarray(pArray, pDatum);
+		}
+	return 0;
+	}
+
+// Check the nesting limit and rejection of a string with a null byte.
+static void testLimits(void) {
+	Datum datum, enc, dec;
+	char *str;
+
+	dinit(&datum);
+	dinit(&enc);
+	dinit(&dec);
+	check(nest(&datum, 1000) == 0);
+	roundTrip(&datum, false);
+	check(nest(&datum, 1001) == 0);
+	check(encode(&datum, &enc) != 0);
+
+	// Encode a string and change one of its characters to a null byte.
+	check(dsetstr("a+b", &datum) == 0);
+	check(encode(&datum, &enc) == 0);
+	check((str = memchr(enc.u.mem.ptr, '+', enc.u.mem.size)) != NULL);
+	if(str != NULL) {
+		*str = '\0';
+		check(ddecode(&dec, enc.u.mem.ptr, enc.u.mem.size, 0) < 0);
+		check(ddecode(&dec, enc.u.mem.ptr, enc.u.mem.size, DDecRef) < 0);
+		}
+	dclear(&datum);
+	dclear(&enc);
+	dclear(&dec);
+	}
+
+int main(void) {
+
+	testRandom();
+	testSequence();
+	testCorrupt();
+	testLimits();
+	return testResult("encodeTest");
+	}
@@ -0,0 +1,105 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// parseTest.c		Test that dparse() reads back the text produced by dtos() with DCvtLang flags and rejects bad text.
+
+#include "test.h"
+
+#define RandomCount	20000		// Number of random datums to round-trip.
+#define NestDepth	4		// Maximum array nesting depth of random datums.
+
+// Convert a datum to text with DCvtLang flags, parse the text, and check that the result converts back to the same text.  (The
+// datums are not compared directly because a byte string without a null byte is read back as a string.)
+static void roundTrip(const Datum *pDatum) {
+	Datum text, parsed, text2;
+	ssize_t n;
+
+	dinit(&text);
+	dinit(&parsed);
+	dinit(&text2);
+	check(dtos(&text, pDatum, NULL, DCvtLang) == 0);
+	check((n = dparse(&parsed, dstr(&text), dstrlen(&text))) == (ssize_t) dstrlen(&text));
+	if(n >= 0) {
+		check(dtos(&text2, &parsed, NULL, DCvtLang) == 0);
+		check(strcmp(dstr(&text2), dstr(&text)) == 0);
+		}
+	dclear(&text);
+	dclear(&parsed);
+	dclear(&text2);
+	}
+
+// Round-trip random datums.
+static void testRandom(void) {
+	Datum datum;
+
+	dinit(&datum);
+	for(int n = 0; n < RandomCount; ++n) {
+		randDatum(&datum, n % (NestDepth + 1));
+		roundTrip(&datum);
+		}
+	dclear(&datum);
+	}
+
+// Check that given text parses successfully, consuming "len" bytes, to a datum that converts to given text.
+static void checkParse(const char *str, ssize_t len, const char *expected) {
+	Datum datum, text;
+
+	dinit(&datum);
+	dinit(&text);
+	check(dparse(&datum, str, strlen(str)) == len);
+	check(dtos(&text, &datum, NULL, DCvtLang) == 0 && strcmp(dstr(&text), expected) == 0);
+	dclear(&datum);
+	dclear(&text);
+	}
+
+// Check parsing of specific text, including white space, number forms, and escape sequences.
+static void testForms(void) {
+	Datum datum;
+
+	checkParse("nil", 3, "nil");
+	checkParse(" \ttrue\n", 7, "true");
+	checkParse("false", 5, "false");
+	checkParse("-45", 3, "-45");
+	checkParse("9223372036854775808", 19, "9223372036854775808");
+	checkParse("18446744073709551616", 20, "1.8446744073709552e+19");
+	checkParse("1.5", 3, "1.5");
+	checkParse("2e-3", 4, "0.002");
+	checkParse("-inf", 4, "-inf");
+	checkParse("'a'", 3, "'a'");
+	checkParse("'\\n'", 4, "'\\n'");
+	checkParse("\"a\\tb\\\"c\"", 9, "\"a\\tb\\\"c\"");
+	checkParse("[ ]", 3, "[]");
+	checkParse("[1, [\"x\", nil], 2.5]", 20, "[1, [\"x\", nil], 2.5]");
+	checkParse("1 2", 2, "1");
+	checkParse("nilx", 3, "nil");
+
+	// Check that a string with a null byte is read as a byte string.
+	dinit(&datum);
+	check(dparse(&datum, "\"a\\0b\"", 6) == 6);
+	check(dtypmem(&datum) && datum.u.mem.size == 3 && memcmp(datum.u.mem.ptr, "a\0b", 3) == 0);
+	dclear(&datum);
+	}
+
+// Check that syntax errors are reported and leave the datum nil.
+static void testErrors(void) {
+	static const char *bad[] = {"", "   ", "tru", "[1, 2", "[1 2]", "[1,]", "\"abc", "'ab'", "''", "-", "1e", "]"};
+	Datum datum;
+
+	dinit(&datum);
+	for(size_t n = 0; n < elementsof(bad); ++n) {
+		dsetint(1, &datum);
+		check(dparse(&datum, bad[n], strlen(bad[n])) < 0);
+		check(datum.type == dat_nil);
+		}
+	dclear(&datum);
+	}
+
+int main(void) {
+
+	testRandom();
+	testForms();
+	testErrors();
+	return testResult("parseTest");
+	}
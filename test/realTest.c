@@ -0,0 +1,152 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// realTest.c		Test inttos(), uinttos(), and realtos() against printf() and strtod().
+
+#include "test.h"
+#include "cxl/lib.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RandomCount	1000000		// Number of random values to check.
+#define ShortestCount	100000		// Number of random reals to check for length against the shortest string.
+#define LongMax		0.005		// Maximum fraction of checked reals whose string may be longer than the shortest.
+
+static long lengthCount = 0;		// Number of reals checked for length.
+static long longCount = 0;		// Number of those whose string was longer than the shortest.
+
+// Return number of significant digits in a number string; that is, digits in the significand, excluding leading and trailing
+// zeros.
+static int sigDigits(const char *str) {
+	int count = 0, zeros = 0;
+	bool leading = true;
+
+	for(; *str != '\0' && *str != 'e'; ++str) {
+		if(*str < '0' || *str > '9')
+			continue;
+		if(*str == '0') {
+			if(!leading)
+				++zeros;
+			}
+		else {
+			count += zeros + 1;
+			zeros = 0;
+			leading = false;
+			}
+		}
+	return count;
+	}
+
+// Return the number of significant digits in the shortest "%.*g" string that converts back to given double.
+static int shortestDigits(double r) {
+	char buf[40];
+
+	for(int prec = 1; prec < 17; ++prec) {
+		sprintf(buf, "%.*g", prec, r);
+		if(strtod(buf, NULL) == r)
+			return sigDigits(buf);
+		}
+	return 17;
+	}
+
+// Convert a double with realtos() and check that the result converts back to the same value and has at most 17 significant
+// digits.  If checkLength is true, also count it if it is longer than the shortest string that converts back (Grisu2 is not
+// always optimal).
+static void checkReal(double r, bool checkLength) {
+	char buf[NumBufSize];
+	char *end = realtos(r, buf);
+
+	check(end == buf + strlen(buf));
+	check(strtod(buf, NULL) == r && signbit(strtod(buf, NULL)) == signbit(r));
+	check(sigDigits(buf) <= 17);
+	if(checkLength) {
+		++lengthCount;
+		if(sigDigits(buf) > shortestDigits(r))
+			++longCount;
+		}
+	}
+
+// Check integer conversions against printf().
+static void testInts(void) {
+	static const long ints[] = {0, 1, -1, 9, 10, 99, 100, -100, 12345, 999999999, 1000000000, LONG_MAX, LONG_MIN,
+	 LONG_MIN + 1};
+	char buf[NumBufSize], ref[NumBufSize];
+	long i;
+	ulong u;
+
+	for(size_t n = 0; n < elementsof(ints); ++n) {
+		inttos(ints[n], buf);
+		sprintf(ref, "%ld", ints[n]);
+		check(strcmp(buf, ref) == 0);
+		}
+	uinttos(ULONG_MAX, buf);
+	sprintf(ref, "%lu", ULONG_MAX);
+	check(strcmp(buf, ref) == 0);
+	for(int n = 0; n < RandomCount; ++n) {
+		u = rand64() >> (rand64() % 64);
+		i = (long) rand64() >> (rand64() % 64);
+		check(uinttos(u, buf) == buf + sprintf(ref, "%lu", u) && strcmp(buf, ref) == 0);
+		check(inttos(i, buf) == buf + sprintf(ref, "%ld", i) && strcmp(buf, ref) == 0);
+		}
+	}
+
+// Check realtos() output format for values whose result is known.
+static void testFormat(void) {
+	static const struct {
+		double r;
+		const char *str;
+		} reals[] = {
+			{0.0, "0"}, {-0.0, "-0"}, {1.0, "1"}, {-2.5, "-2.5"}, {100.0, "100"}, {0.1, "0.1"},
+			{0.1 + 0.2, "0.30000000000000004"}, {1e-4, "0.0001"}, {1e-5, "1e-05"}, {1e15, "1000000000000000"},
+			{1e16, "1e+16"}, {123456789012345.0, "123456789012345"}, {1.5e300, "1.5e+300"}, {5e-324, "5e-324"},
+			{DBL_MAX, "1.7976931348623157e+308"}, {DBL_MIN, "2.2250738585072014e-308"}};
+	char buf[NumBufSize];
+
+	for(size_t n = 0; n < elementsof(reals); ++n) {
+		realtos(reals[n].r, buf);
+		check(strcmp(buf, reals[n].str) == 0);
+		}
+	realtos(INFINITY, buf);
+	check(strcmp(buf, "inf") == 0);
+	realtos(-INFINITY, buf);
+	check(strcmp(buf, "-inf") == 0);
+	realtos(NAN, buf);
+	check(strcmp(buf, "nan") == 0);
+	}
+
+// Check that realtos() round-trips random doubles (random bit patterns and random values of moderate magnitude).
+static void testRoundTrip(void) {
+	uint64_t bits;
+	double r;
+	char buf[16];
+
+	for(int n = 0; n < RandomCount; ++n) {
+		bits = rand64();
+		memcpy((void *) &r, (void *) &bits, sizeof(r));
+		if(isfinite(r))
+			checkReal(r, n < ShortestCount);
+		checkReal((double) (rand64() >> 11) / (double) (1ull << (n % 40)), n < ShortestCount);
+		}
+
+	// Powers of ten and their neighbors, where digit generation is most delicate.
+	for(int exp = -323; exp <= 308; ++exp) {
+		sprintf(buf, "1e%d", exp);
+		r = strtod(buf, NULL);
+		checkReal(r, true);
+		checkReal(nextafter(r, 0.0), true);
+		checkReal(nextafter(r, INFINITY), true);
+		}
+	check(longCount <= lengthCount * LongMax);
+	}
+
+int main(void) {
+
+	testInts();
+	testFormat();
+	testRoundTrip();
+	return testResult("realTest");
+	}
@@ -0,0 +1,118 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// test.h		Definitions shared by the CXL regression test programs.
+
+#ifndef test_h
+#define test_h
+
+#include "stdos.h"
+#include "cxl/excep.h"
+#include "cxl/datum.h"
+#include "cxl/array.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+// Check a condition and report it (with the current exception message, if any) if false.
+#define check(cond)	((cond) ? (void) 0 : checkFail(#cond, __FILE__, __LINE__))
+
+static int failCount = 0;		// Number of failed checks.
+
+// Report a failed check.
+static inline void checkFail(const char *cond, const char *file, int line) {
+
+	fprintf(stderr, "%s:%d: check failed: %s", file, line, cond);
+	if(cxlExcep.flags & ExMessage)
+		fprintf(stderr, " (%s)", cxlExcep.msg);
+	fputc('\n', stderr);
+	++failCount;
+	}
+
+// Return next 64-bit pseudo-random number (xorshift64*), so that test data is the same on every run.
+static inline uint64_t rand64(void) {
+	static uint64_t randState = 0x9e3779b97f4a7c15ull;
+
+	randState ^= randState >> 12;
+	randState ^= randState << 25;
+	randState ^= randState >> 27;
+	return randState * 0x2545f4914f6cdd1dull;
+	}
+
+// Set a random datum of any type in *pDatum, with arrays nested at most "depth" levels deep.  Real numbers are finite (so that
+// the datum is equal to itself).  Strings and byte strings contain any bytes, and may be short or long.
+static inline void randDatum(Datum *pDatum, int depth) {
+	uint64_t u = rand64();
+
+	switch(u % (depth > 0 ? 11 : 10)) {
+		case 0:
+			dsetnil(pDatum);
+			break;
+		case 1:
+			dsetbool(u & 0x100, pDatum);
+			break;
+		case 2:
+			dsetchr((u >> 8) % 255 + 1, pDatum);
+			break;
+		case 3:
+			dsetint((long) rand64() >> (u >> 8) % 64, pDatum);
+			break;
+		case 4:
+			dsetuint(rand64() | 0x8000000000000000ull, pDatum);
+			break;
+		case 5:
+			{double r;
+
+			do {
+				u = rand64();
+				memcpy((void *) &r, (void *) &u, sizeof(r));
+				} while(!isfinite(r));
+			dsetreal(r, pDatum);
+			}
+			break;
+		case 6:
+		case 7:
+		case 8:
+		case 9:
+			{char buf[3000];
+			size_t len = (u >> 8) % 4 == 0 ? rand64() % sizeof(buf) : rand64() % 30;
+			bool binary = (u >> 12) % 8 == 0;
+
+			for(size_t i = 0; i < len; ++i)
+				buf[i] = (u >> 16) % 2 ? rand64() % 256 : ' ' + rand64() % 95;
+			if(!binary)
+				for(size_t i = 0; i < len; ++i)
+					if(buf[i] == '\0')
+						buf[i] = '0';
+			if((binary ? dsetmem((void *) buf, len, pDatum) : dsetsubstr(buf, len, pDatum)) != 0)
+				checkFail("dsetmem() or dsetsubstr()", __FILE__, __LINE__);
+			}
+			break;
+		default:
+			{Array *pArray = anew(rand64() % 6, NULL);
+
+			if(pArray == NULL)
+				checkFail("anew()", __FILE__, __LINE__);
+			else {
+				for(ArraySize i = 0; i < pArray->used; ++i)
+					randDatum(pArray->elements + i, depth - 1);
+				dadoptarray(pArray, pDatum);
+				}
+			}
+		}
+	}
+
+// Print test result and return exit status for main().
+static inline int testResult(const char *name) {
+
+	if(failCount == 0) {
+		printf("%s: all checks passed.\n", name);
+		return 0;
+		}
+	printf("%s: %d check(s) failed.\n", name, failCount);
+	return 1;
+	}
+#endif
@@ -0,0 +1,213 @@
+// CXL (c) Copyright 2022 Richard W. Marinelli
+//
+// This work is licensed under the GNU General Public License (GPLv3).  To view a copy of this license, see the
+// "License.txt" file included with this distribution or visit http://www.gnu.org/licenses/gpl-3.0.en.html.
+//
+// vectorTest.c		Test vector predicates, conversions, and reductions against simple element-by-element loops.
+
+#include "test.h"
+#include "cxl/vector.h"
+
+#define RandomCount	1000		// Number of random elements in each vector.
+
+// Return true if element x satisfies predicate "x cmp y", computed in long double (which holds any long or unsigned long
+// exactly on platforms where it is wider than double).
+static bool sat(long double x, ushort cmp, long double y) {
+
+	switch(cmp) {
+		case VCmpEQ:
+			return x == y;
+		case VCmpNE:
+			return !(x == y);
+		case VCmpLT:
+			return x < y;
+		case VCmpLE:
+			return x <= y;
+		case VCmpGT:
+			return x > y;
+		default:
+			return x >= y;
+		}
+	}
+
+// Return element of a vector as a long double.
+static long double el(const Vector *pVec, ArraySize i) {
+
+	return pVec->type == dat_int ? (long double) pVec->u.intNums[i] : pVec->type == dat_uint ?
+	 (long double) pVec->u.uintNums[i] : (long double) pVec->u.realNums[i];
+	}
+
+// Check vcount() and vfilter() on a vector for every operator, given comparison value, against a loop.
+static void checkPredicate(Vector *pVec, const Datum *pVal) {
+	long double y = pVal->type == dat_int ? (long double) pVal->u.intNum : pVal->type == dat_uint ?
+	 (long double) pVal->u.uintNum : (long double) pVal->u.realNum;
+	Vector *pVec1;
+	ArraySize n, j;
+
+	for(ushort cmp = VCmpEQ; cmp <= VCmpGE; ++cmp) {
+		n = 0;
+		for(ArraySize i = 0; i < pVec->used; ++i)
+			n += sat(el(pVec, i), cmp, y);
+		check(vcount(pVec, cmp, pVal) == n);
+		check((pVec1 = vfilter(pVec, cmp, pVal, 0)) != NULL);
+		if(pVec1 != NULL) {
+			check(pVec1->used == n);
+			j = 0;
+			for(ArraySize i = 0; i < pVec->used && j < pVec1->used; ++i)
+				if(sat(el(pVec, i), cmp, y))
+					check(el(pVec1, j++) == el(pVec, i));
+			vfree(pVec1);
+			}
+		}
+	}
+
+// Check predicates on integer and unsigned integer vectors with integer, unsigned, and real comparison values, including
+// values that are not integers or are out of range for the element type.
+static void testPredicates(void) {
+	static const double reals[] = {0.0, -0.0, 3.5, -2.5, 3.0, -0.5, 0.25, 10.5, -10.5, 9.3e18, -9.3e18, 1.9e19, 1e30, -1e30,
+	 INFINITY, -INFINITY};
+	static const long ints[] = {0, 1, -1, 5, -5, LONG_MAX, LONG_MIN};
+	Vector *pVecInt = vnew(dat_int, 0), *pVecUint = vnew(dat_uint, 0);
+	Datum val;
+
+	dinit(&val);
+	check(pVecInt != NULL && pVecUint != NULL);
+	if(pVecInt == NULL || pVecUint == NULL)
+		return;
+	for(long i = -10; i <= 10; ++i) {
+		dsetint(i, &val);
+		check(vpush(pVecInt, &val) == 0);
+		if(i >= 0)
+			check(vpush(pVecUint, &val) == 0);
+		}
+	dsetint(LONG_MAX, &val);
+	check(vpush(pVecInt, &val) == 0);
+	dsetint(LONG_MIN, &val);
+	check(vpush(pVecInt, &val) == 0);
+	dsetuint(ULONG_MAX, &val);
+	check(vpush(pVecUint, &val) == 0);
+
+	for(size_t n = 0; n < elementsof(reals); ++n) {
+		dsetreal(reals[n], &val);
+		checkPredicate(pVecInt, &val);
+		checkPredicate(pVecUint, &val);
+		}
+	for(size_t n = 0; n < elementsof(ints); ++n) {
+		dsetint(ints[n], &val);
+		checkPredicate(pVecInt, &val);
+		checkPredicate(pVecUint, &val);
+		}
+	dsetuint(ULONG_MAX, &val);
+	checkPredicate(pVecInt, &val);
+	checkPredicate(pVecUint, &val);
+
+	// NaN satisfies only VCmpNE.
+	dsetreal(NAN, &val);
+	check(vcount(pVecInt, VCmpNE, &val) == pVecInt->used);
+	check(vcount(pVecInt, VCmpEQ, &val) == 0 && vcount(pVecInt, VCmpLE, &val) == 0 && vcount(pVecInt, VCmpGE, &val) == 0);
+
+	vfree(pVecInt);
+	vfree(pVecUint);
+	}
+
+// Check that numbers that cannot be converted exactly to an integer vector's element type are rejected.
+static void testConversions(void) {
+	Vector *pVecInt = vnew(dat_int, 0), *pVecUint = vnew(dat_uint, 0);
+	Datum val;
+
+	dinit(&val);
+	check(pVecInt != NULL && pVecUint != NULL);
+	if(pVecInt == NULL || pVecUint == NULL)
+		return;
+	dsetreal(3.5, &val);
+	check(vpush(pVecInt, &val) != 0 && vcalcn(pVecInt, VCalcAdd, &val) != 0);
+	dsetreal(NAN, &val);
+	check(vpush(pVecInt, &val) != 0);
+	dsetreal(1e30, &val);
+	check(vpush(pVecInt, &val) != 0);
+	dsetreal(-1.0, &val);
+	check(vpush(pVecUint, &val) != 0);
+	dsetint(-1, &val);
+	check(vpush(pVecUint, &val) != 0);
+	dsetuint(ULONG_MAX, &val);
+	check(vpush(pVecInt, &val) != 0);
+	check(pVecInt->used == 0 && pVecUint->used == 0);
+
+	dsetreal(-4.0, &val);
+	check(vpush(pVecInt, &val) == 0 && pVecInt->u.intNums[0] == -4);
+	dsetreal(-0.0, &val);
+	check(vpush(pVecUint, &val) == 0 && pVecUint->u.uintNums[0] == 0);
+	vfree(pVecInt);
+	vfree(pVecUint);
+	}
+
+// Check reductions and string conversion of random vectors against simple loops.
+static void testReductions(void) {
+	Vector *pVecInt = vnew(dat_int, RandomCount), *pVecReal = vnew(dat_real, RandomCount);
+	Datum val;
+	long sum = 0, min = LONG_MAX, max = LONG_MIN;
+	double rmin = INFINITY, rmax = -INFINITY;
+
+	dinit(&val);
+	check(pVecInt != NULL && pVecReal != NULL);
+	if(pVecInt == NULL || pVecReal == NULL)
+		return;
+	for(ArraySize i = 0; i < RandomCount; ++i) {
+		long x = (long) (rand64() % 2000001) - 1000000;
+		double r = (double) x / 8.0;
+
+		pVecInt->u.intNums[i] = x;
+		pVecReal->u.realNums[i] = r;
+		sum += x;
+		if(x < min)
+			min = x;
+		if(x > max)
+			max = x;
+		if(r < rmin)
+			rmin = r;
+		if(r > rmax)
+			rmax = r;
+		}
+	vsum(&val, pVecInt);
+	check(val.type == dat_int && val.u.intNum == sum);
+	vmin(&val, pVecInt);
+	check(val.type == dat_int && val.u.intNum == min);
+	vmax(&val, pVecInt);
+	check(val.type == dat_int && val.u.intNum == max);
+
+	// Eighths of integers of this size are summed exactly in any order.
+	vsum(&val, pVecReal);
+	check(val.type == dat_real && val.u.realNum == (double) sum / 8.0);
+	vmin(&val, pVecReal);
+	check(val.type == dat_real && val.u.realNum == rmin);
+	vmax(&val, pVecReal);
+	check(val.type == dat_real && val.u.realNum == rmax);
+
+	// String form matches that of the equivalent array.
+	{Array *pArray = vtoarray(pVecInt);
+	Datum array, str1, str2;
+
+	dinit(&array);
+	dinit(&str1);
+	dinit(&str2);
+	check(pArray != NULL);
+	if(pArray != NULL) {
+		dadoptarray(pArray, &array);
+		check(vtos(&str1, pVecInt, NULL, DCvtLang) == 0 && dtos(&str2, &array, NULL, DCvtLang) == 0);
+		check(strcmp(dstr(&str1), dstr(&str2)) == 0);
+		}
+	dclear(&array);
+	dclear(&str1);
+	dclear(&str2);
+	}
+	vfree(pVecInt);
+	vfree(pVecReal);
+	}
+
+int main(void) {
+
+	testPredicates();
+	testConversions();
+	testReductions();
+	return testResult("vectorTest");
+	}